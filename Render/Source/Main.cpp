@@ -0,0 +1,896 @@
+/*
+  ==============================================================================
+
+	Main.cpp
+	Created: 19 Oct 2026 3:02:48pm
+	Author:  Abhinav Natarajan
+
+	Headless crossfeed for shell pipelines, e.g. decoder | CrossFeedRender | encoder.
+	Interleaved PCM (raw, or WAV framed) is read from stdin and written to stdout as stereo in the
+	same sample format, aligned for the processor's latency. Given --in and --out, a WAV file is
+	rendered offline instead, straight from memory-mapped pages.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+#include "Scale.h"
+#include "Stress.h"
+#include "Tests.h"
+#include "Verify.h"
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#if JUCE_WINDOWS
+ #include <fcntl.h>
+ #include <io.h>
+#endif
+
+namespace {
+
+enum class SampleFormat { s16, s24, s32, f32 };
+
+struct StreamFormat {
+	SampleFormat sampleFormat { SampleFormat::s16 };
+	int numChannels { 2 };
+	double sampleRate { 44100.0 };
+	bool isWav { false };
+	// length of the WAV data chunk, or 0 when streamed with an unknown length
+	uint64 dataBytes { 0 };
+
+	size_t getBytesPerSample () const noexcept {
+		switch (sampleFormat) {
+		case SampleFormat::s16: return 2;
+		case SampleFormat::s24: return 3;
+		default: return 4;
+		}
+	}
+};
+
+// set from the signal handler; the control file is re-read between blocks
+volatile std::sig_atomic_t reloadRequested { 0 };
+
+void requestReload (int)
+{
+	reloadRequested = 1;
+}
+
+// large stdio buffers, so reads and writes reach the pipe in big chunks
+constexpr size_t streamBufferSize { 1 << 20 };
+char inputStreamBuffer[streamBufferSize];
+char outputStreamBuffer[streamBufferSize];
+
+size_t readFully (void* destination, size_t numBytes)
+{
+	auto bytes = static_cast<char*> (destination);
+	size_t total = 0;
+	while (total < numBytes) {
+		auto n = std::fread (bytes + total, 1, numBytes - total, stdin);
+		if (n == 0)
+			break;
+		total += n;
+	}
+	return total;
+}
+
+uint32 readLittleEndian (const unsigned char* bytes, int numBytes) noexcept
+{
+	uint32 value = 0;
+	for (int i = numBytes; --i >= 0;)
+		value = (value << 8) | bytes[i];
+	return value;
+}
+
+void writeLittleEndian (unsigned char* bytes, uint32 value, int numBytes) noexcept
+{
+	for (int i = 0; i < numBytes; ++i, value >>= 8)
+		bytes[i] = static_cast<unsigned char> (value & 0xff);
+}
+
+// reads the rest of a RIFF header up to the start of the sample data; "RIFF" has already been read
+bool readWavHeader (StreamFormat& format)
+{
+	unsigned char header[8];
+	if (readFully (header, 8) != 8 || std::memcmp (header + 4, "WAVE", 4) != 0)
+		return false;
+
+	bool hasFormat = false;
+	for (;;) {
+		if (readFully (header, 8) != 8)
+			return false;
+		auto chunkSize = readLittleEndian (header + 4, 4);
+
+		if (std::memcmp (header, "data", 4) == 0) {
+			format.dataBytes = chunkSize == 0xffffffff ? 0 : chunkSize;
+			return hasFormat;
+		}
+
+		if (std::memcmp (header, "fmt ", 4) == 0 && chunkSize >= 16 && chunkSize <= 64) {
+			unsigned char fmt[64];
+			if (readFully (fmt, chunkSize + (chunkSize & 1)) != chunkSize + (chunkSize & 1))
+				return false;
+			auto tag = readLittleEndian (fmt, 2);
+			// WAVE_FORMAT_EXTENSIBLE keeps the real tag at the start of the sub-format GUID
+			if (tag == 0xfffe && chunkSize >= 26)
+				tag = readLittleEndian (fmt + 24, 2);
+			auto bits = readLittleEndian (fmt + 14, 2);
+			format.numChannels = int (readLittleEndian (fmt + 2, 2));
+			format.sampleRate = double (readLittleEndian (fmt + 4, 4));
+			if (tag == 3 && bits == 32)
+				format.sampleFormat = SampleFormat::f32;
+			else if (tag == 1 && bits == 16)
+				format.sampleFormat = SampleFormat::s16;
+			else if (tag == 1 && bits == 24)
+				format.sampleFormat = SampleFormat::s24;
+			else if (tag == 1 && bits == 32)
+				format.sampleFormat = SampleFormat::s32;
+			else
+				return false;
+			hasFormat = true;
+			continue;
+		}
+
+		// skip any other chunk, padded to an even length
+		for (uint32 remaining = chunkSize + (chunkSize & 1); remaining > 0;) {
+			unsigned char skip[256];
+			auto n = readFully (skip, jmin (remaining, uint32 (sizeof (skip))));
+			if (n == 0)
+				return false;
+			remaining -= uint32 (n);
+		}
+	}
+}
+
+// a streamed WAV header; the lengths are unknown, so they are left at their maximum
+void writeWavHeader (const StreamFormat& format)
+{
+	auto bytesPerSample = uint32 (format.getBytesPerSample ());
+	auto blockAlign = bytesPerSample * uint32 (format.numChannels);
+	unsigned char header[44];
+	std::memcpy (header, "RIFF", 4);
+	writeLittleEndian (header + 4, 0xffffffff, 4);
+	std::memcpy (header + 8, "WAVEfmt ", 8);
+	writeLittleEndian (header + 16, 16, 4);
+	writeLittleEndian (header + 20, format.sampleFormat == SampleFormat::f32 ? 3 : 1, 2);
+	writeLittleEndian (header + 22, uint32 (format.numChannels), 2);
+	writeLittleEndian (header + 24, uint32 (format.sampleRate), 4);
+	writeLittleEndian (header + 28, uint32 (format.sampleRate) * blockAlign, 4);
+	writeLittleEndian (header + 32, blockAlign, 2);
+	writeLittleEndian (header + 34, bytesPerSample * 8, 2);
+	std::memcpy (header + 36, "data", 4);
+	writeLittleEndian (header + 40, 0xffffffff, 4);
+	std::fwrite (header, 1, sizeof (header), stdout);
+}
+
+// converts one channel of numFrames frames, srcStride bytes apart, to floats dstStride apart
+void decodeChannel (const unsigned char* src, int srcStride, SampleFormat sampleFormat, float* dst, int dstStride, int numFrames) noexcept
+{
+	switch (sampleFormat) {
+	case SampleFormat::s16:
+		for (int i = 0; i < numFrames; ++i, src += srcStride, dst += dstStride)
+			*dst = float (int16 (readLittleEndian (src, 2))) * (1.0f / 32768.0f);
+		break;
+	case SampleFormat::s24:
+		for (int i = 0; i < numFrames; ++i, src += srcStride, dst += dstStride)
+			*dst = float (int32 (readLittleEndian (src, 3) << 8) >> 8) * (1.0f / 8388608.0f);
+		break;
+	case SampleFormat::s32:
+		for (int i = 0; i < numFrames; ++i, src += srcStride, dst += dstStride)
+			*dst = float (double (int32 (readLittleEndian (src, 4))) * (1.0 / 2147483648.0));
+		break;
+	case SampleFormat::f32:
+		for (int i = 0; i < numFrames; ++i, src += srcStride, dst += dstStride) {
+			auto bits = readLittleEndian (src, 4);
+			std::memcpy (dst, &bits, 4);
+		}
+		break;
+	}
+}
+
+void encodeChannel (const float* src, int srcStride, SampleFormat sampleFormat, unsigned char* dst, int dstStride, int numFrames) noexcept
+{
+	switch (sampleFormat) {
+	case SampleFormat::s16:
+		for (int i = 0; i < numFrames; ++i, src += srcStride, dst += dstStride)
+			writeLittleEndian (dst, uint32 (roundToInt (jlimit (-32768.0f, 32767.0f, *src * 32768.0f))), 2);
+		break;
+	case SampleFormat::s24:
+		for (int i = 0; i < numFrames; ++i, src += srcStride, dst += dstStride)
+			writeLittleEndian (dst, uint32 (roundToInt (jlimit (-8388608.0f, 8388607.0f, *src * 8388608.0f))), 3);
+		break;
+	case SampleFormat::s32:
+		for (int i = 0; i < numFrames; ++i, src += srcStride, dst += dstStride)
+			writeLittleEndian (dst, uint32 (int32 (jlimit (-2147483648.0, 2147483647.0, std::round (double (*src) * 2147483648.0)))), 4);
+		break;
+	case SampleFormat::f32:
+		for (int i = 0; i < numFrames; ++i, src += srcStride, dst += dstStride) {
+			uint32 bits;
+			std::memcpy (&bits, src, 4);
+			writeLittleEndian (dst, bits, 4);
+		}
+		break;
+	}
+}
+
+void decode (const unsigned char* bytes, const StreamFormat& format, AudioBuffer<float>& buffer, int numFrames) noexcept
+{
+	auto bytesPerSample = int (format.getBytesPerSample ());
+	auto stride = bytesPerSample * format.numChannels;
+	for (int chan = 0; chan < format.numChannels; ++chan)
+		decodeChannel (bytes + chan * bytesPerSample, stride, format.sampleFormat, buffer.getWritePointer (chan), 1, numFrames);
+}
+
+void encode (const AudioBuffer<float>& buffer, int startFrame, int numFrames, const StreamFormat& format, unsigned char* bytes) noexcept
+{
+	auto bytesPerSample = int (format.getBytesPerSample ());
+	auto stride = bytesPerSample * format.numChannels;
+	for (int chan = 0; chan < format.numChannels; ++chan)
+		encodeChannel (buffer.getReadPointer (chan, startFrame), 1, format.sampleFormat, bytes + chan * bytesPerSample, stride, numFrames);
+}
+
+// the same for interleaved frames, which stereo streams keep from end to end
+void decodeInterleaved (const unsigned char* bytes, const StreamFormat& format, float* frames, int numFrames) noexcept
+{
+	auto bytesPerSample = int (format.getBytesPerSample ());
+	auto stride = bytesPerSample * format.numChannels;
+	for (int chan = 0; chan < format.numChannels; ++chan)
+		decodeChannel (bytes + chan * bytesPerSample, stride, format.sampleFormat, frames + chan, format.numChannels, numFrames);
+}
+
+void encodeInterleaved (const float* frames, int numFrames, const StreamFormat& format, unsigned char* bytes) noexcept
+{
+	auto bytesPerSample = int (format.getBytesPerSample ());
+	auto stride = bytesPerSample * format.numChannels;
+	for (int chan = 0; chan < format.numChannels; ++chan)
+		encodeChannel (frames + chan, format.numChannels, format.sampleFormat, bytes + chan * bytesPerSample, stride, numFrames);
+}
+
+bool setParameter (AudioProcessor& processor, const String& id, float value)
+{
+	for (auto* parameter : processor.getParameters ()) {
+		if (auto* ranged = dynamic_cast<RangedAudioParameter*> (parameter)) {
+			if (ranged->paramID == id) {
+				ranged->setValueNotifyingHost (ranged->convertTo0to1 (value));
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// "ID value" or "ID=value" per line, with # starting a comment
+void loadControlFile (AudioProcessor& processor, const std::string& path)
+{
+	std::ifstream file (path);
+	if (! file) {
+		std::fprintf (stderr, "CrossFeedRender: cannot read control file %s\n", path.c_str ());
+		return;
+	}
+
+	std::string line;
+	while (std::getline (file, line)) {
+		line = line.substr (0, line.find ('#'));
+		std::replace (line.begin (), line.end (), '=', ' ');
+		std::istringstream fields (line);
+		std::string id;
+		float value;
+		if (fields >> id >> value && ! setParameter (processor, id, value))
+			std::fprintf (stderr, "CrossFeedRender: unknown parameter %s\n", id.c_str ());
+	}
+}
+
+void printUsage ()
+{
+	std::fprintf (stderr,
+		"usage: CrossFeedRender [options] < input > output\n"
+		"       CrossFeedRender [options] --in input.wav --out output.wav\n"
+		"  --format s16|s24|s32|f32   raw input sample format (default s16)\n"
+		"  --rate Hz                  raw input sample rate (default 44100)\n"
+		"  --channels 2|6|8           raw input channels (default 2)\n"
+		"  --block frames             frames processed per block (default 4096, or 65536 rendering\n"
+		"                             one file, which the processor splits across the cores)\n"
+		"  --set ID=value             set a parameter, e.g. --set XGAIN=-6\n"
+		"  --control file             parameter file, re-read on SIGHUP\n"
+		"  --poll blocks              also re-read the control file every so many blocks\n"
+		"  --no-align                 keep the processor latency at the start of the output\n"
+		"  --grid ID=v1,v2,...        with --in, render every combination of the grid values to the\n"
+		"                             directory --out, as input_ID1v1_ID2v1.wav and so on\n"
+		"  --jobs n                   grid render threads (default: one per CPU)\n"
+		"  --verify                   compare the processor and fixed point engine with a double\n"
+		"                             precision model on built-in stimuli, at --rate and --set,\n"
+		"                             then at default settings\n"
+		"  --test                     run the unit tests: the --verify corpus at several rates,\n"
+		"                             block sizes and settings, and a short --stress run; exits\n"
+		"                             non-zero on any failure\n"
+		"  --stress blocks            drive the processor with random block sizes, sample rates,\n"
+		"                             automation and bypass, checking output, allocations and time\n"
+		"  --budget percent           stress: also fail when a block takes longer than this share\n"
+		"                             of its duration\n"
+		"  --seed n                   stress: random seed (default 1)\n"
+		"  --scale n1,n2,...          benchmark sessions of n1, n2... instances on --jobs threads,\n"
+		"                             in --block sized callbacks at --rate\n"
+		"  --automation b1,b2,...     benchmark static parameters against an automation storm\n"
+		"                             that moves them every segment, in b1, b2... sample blocks\n"
+		"WAV input is detected from its header; its format overrides the raw options.\n"
+		"With --in, the WAV file is memory mapped and rendered to --out in its own bit depth.\n");
+}
+
+AudioChannelSet getInputLayout (int numChannels)
+{
+	switch (numChannels) {
+	case 2: return AudioChannelSet::stereo ();
+	case 6: return AudioChannelSet::create5point1 ();
+	case 8: return AudioChannelSet::create7point1 ();
+	default: return AudioChannelSet::disabled ();
+	}
+}
+
+struct Options {
+	int blockSize { 4096 };
+	// a single file renders in long blocks unless --block says otherwise, so that the processor
+	// can split each one across the cores
+	static constexpr int fileBlockSize { 65536 };
+	bool hasBlockSize { false };
+	int pollInterval { 0 };
+	bool align { true };
+	std::string controlPath;
+	std::vector<std::pair<String, float>> settings;
+	// batch mode: every combination of these values is rendered to its own file
+	std::vector<std::pair<String, std::vector<float>>> grid;
+	int numJobs { 0 };
+	bool verify { false };
+	bool test { false };
+	// stress mode, when a number of blocks is given
+	int64 stressBlocks { 0 };
+	double budget { 0.0 };
+	uint32 seed { 1 };
+	// scaling benchmark, when instance counts are given
+	std::vector<int> instanceCounts;
+	// automation benchmark, when block sizes are given
+	std::vector<int> automationBlockSizes;
+	// file mode, when an input file is given
+	String inputPath;
+	String outputPath;
+};
+
+bool prepareProcessor (CrossFeedAudioProcessor& processor, int numChannels, double sampleRate, const Options& options)
+{
+	auto layout = getInputLayout (numChannels);
+	AudioProcessor::BusesLayout buses;
+	buses.inputBuses.add (layout);
+	buses.outputBuses.add (AudioChannelSet::stereo ());
+	// the A/B comparison's second output stays off: renders hear the selected setting
+	buses.outputBuses.add (AudioChannelSet::disabled ());
+	if (options.blockSize <= 0 || sampleRate <= 0 || layout == AudioChannelSet::disabled ()
+		|| ! processor.setBusesLayout (buses)) {
+		std::fprintf (stderr, "CrossFeedRender: unsupported input (%d channels at %g Hz)\n", numChannels, sampleRate);
+		return false;
+	}
+	processor.setNonRealtime (true);
+	processor.setRateAndBufferSizeDetails (sampleRate, options.blockSize);
+
+	for (auto& s : options.settings)
+		if (! setParameter (processor, s.first, s.second))
+			std::fprintf (stderr, "CrossFeedRender: unknown parameter %s\n", s.first.toRawUTF8 ());
+	if (! options.controlPath.empty ())
+		loadControlFile (processor, options.controlPath);
+#ifdef SIGHUP
+	std::signal (SIGHUP, requestReload);
+#endif
+
+	processor.prepareToPlay (sampleRate, options.blockSize);
+	return true;
+}
+
+// between blocks, so parameter changes never land in the middle of one
+void pollControlFile (AudioProcessor& processor, const Options& options, int blockNumber)
+{
+	if (reloadRequested != 0 || (options.pollInterval > 0 && blockNumber % options.pollInterval == 0)) {
+		reloadRequested = 0;
+		if (! options.controlPath.empty ())
+			loadControlFile (processor, options.controlPath);
+	}
+}
+
+int renderPipe (CrossFeedAudioProcessor& processor, const StreamFormat& input, const unsigned char* prefix, size_t prefixSize, const Options& options)
+{
+	auto blockSize = options.blockSize;
+	StreamFormat output = input;
+	output.numChannels = 2;
+	if (output.isWav)
+		writeWavHeader (output);
+
+	// everything the loop touches is allocated here, once
+	auto inputFrameBytes = input.getBytesPerSample () * size_t (input.numChannels);
+	auto outputFrameBytes = output.getBytesPerSample () * 2;
+	HeapBlock<unsigned char> inputBytes (size_t (blockSize) * inputFrameBytes);
+	HeapBlock<unsigned char> outputBytes (size_t (blockSize) * outputFrameBytes);
+	AudioBuffer<float> buffer (input.numChannels, blockSize);
+	// stereo stays interleaved from decode to encode, through the processor's interleaved path
+	bool interleaved = input.numChannels == 2;
+	HeapBlock<float> frames (interleaved ? size_t (blockSize) * 2 : 0);
+	MidiBuffer midi;
+	std::memcpy (inputBytes.get (), prefix, prefixSize);
+
+	// the first latency frames are the processor filling up; skip them and flush as many at the end
+	int latency = processor.getLatencySamples ();
+	int toSkip = options.align ? latency : 0;
+	int toFlush = options.align ? latency : 0;
+	bool endOfInput = false;
+	uint64 remainingBytes = input.dataBytes > 0 ? input.dataBytes : std::numeric_limits<uint64>::max ();
+
+	for (int blockNumber = 1;; ++blockNumber) {
+		pollControlFile (processor, options, blockNumber);
+
+		int numFrames;
+		if (! endOfInput) {
+			// a WAV stream may carry more chunks after the audio, so stop at the end of the data chunk
+			auto wanted = size_t (jmin (uint64 (size_t (blockSize) * inputFrameBytes), remainingBytes));
+			auto bytes = prefixSize + readFully (inputBytes.get () + prefixSize, wanted - prefixSize);
+			prefixSize = 0;
+			remainingBytes -= bytes;
+			numFrames = int (bytes / inputFrameBytes);
+			endOfInput = numFrames < blockSize;
+			if (numFrames == 0)
+				continue;
+			if (interleaved)
+				decodeInterleaved (inputBytes.get (), input, frames.get (), numFrames);
+			else
+				decode (inputBytes.get (), input, buffer, numFrames);
+		}
+		else {
+			numFrames = jmin (toFlush, blockSize);
+			toFlush -= numFrames;
+			if (interleaved)
+				FloatVectorOperations::clear (frames.get (), 2 * numFrames);
+			else
+				buffer.clear (0, numFrames);
+		}
+		if (numFrames == 0)
+			break;
+
+		auto skipped = jmin (toSkip, numFrames);
+		toSkip -= skipped;
+		if (interleaved) {
+			processor.processInterleaved (frames.get (), numFrames, midi);
+			encodeInterleaved (frames.get () + 2 * skipped, numFrames - skipped, output, outputBytes.get ());
+		}
+		else {
+			// refer to the block without resizing the buffer, so nothing is allocated
+			AudioBuffer<float> block (buffer.getArrayOfWritePointers (), input.numChannels, numFrames);
+			processor.processBlock (block, midi);
+			encode (block, skipped, numFrames - skipped, output, outputBytes.get ());
+		}
+		std::fwrite (outputBytes.get (), outputFrameBytes, size_t (numFrames - skipped), stdout);
+	}
+
+	std::fflush (stdout);
+	return 0;
+}
+
+// Offline rendering of a WAV file, in three stages on their own threads: the reader copies blocks
+// out of a window of mapped pages that slides along the file, the processor renders them, and the
+// writer encodes them to disk. Blocks travel through a fixed ring of chunks, so memory use is bounded
+// by the window and the ring, and a stage that gets ahead waits for a free chunk. The render then
+// runs at the speed of the slowest stage rather than of all three in turn.
+constexpr int64 mappedWindowFrames { 1 << 18 };
+constexpr int numChunks { 8 };
+
+struct Chunk {
+	AudioBuffer<float> audio;
+	int numFrames { 0 };
+	// frames at the start that are not written, while the latency is trimmed
+	int skip { 0 };
+};
+
+// single producer single consumer queue of chunk indices. Pushing and popping are lock-free; the
+// event only puts an idle consumer to sleep. There is room for every chunk and the end marker, so a
+// push never waits: the backpressure comes from the reader running out of free chunks.
+class ChunkQueue {
+public:
+	static constexpr int endOfStream { -1 };
+
+	void push (int chunk) noexcept {
+		int start1, size1, start2, size2;
+		fifo.prepareToWrite (1, start1, size1, start2, size2);
+		jassert (size1 == 1);
+		slots[size_t (start1)] = chunk;
+		fifo.finishedWrite (1);
+		ready.signal ();
+	}
+
+	int pop () noexcept {
+		while (fifo.getNumReady () == 0)
+			ready.wait ();
+		int start1, size1, start2, size2;
+		fifo.prepareToRead (1, start1, size1, start2, size2);
+		auto chunk = slots[size_t (start1)];
+		fifo.finishedRead (1);
+		return chunk;
+	}
+
+private:
+	// an AbstractFifo holds one item less than its size
+	std::array<int, numChunks + 2> slots;
+	AbstractFifo fifo { numChunks + 2 };
+	WaitableEvent ready;
+};
+
+int renderFile (CrossFeedAudioProcessor& processor, MemoryMappedAudioFormatReader& reader, const Options& options)
+{
+	File outputFile (File::getCurrentWorkingDirectory ().getChildFile (options.outputPath));
+	outputFile.deleteFile ();
+	std::unique_ptr<FileOutputStream> stream (outputFile.createOutputStream ());
+	WavAudioFormat wav;
+	std::unique_ptr<AudioFormatWriter> writer;
+	if (stream != nullptr)
+		writer.reset (wav.createWriterFor (stream.get (), reader.sampleRate, 2, int (reader.bitsPerSample), {}, 0));
+	if (writer == nullptr) {
+		std::fprintf (stderr, "CrossFeedRender: cannot write %s\n", options.outputPath.toRawUTF8 ());
+		return 1;
+	}
+	stream.release (); // now owned by the writer
+
+	auto blockSize = options.blockSize;
+	auto numChannels = int (reader.numChannels);
+	int latency = processor.getLatencySamples ();
+	std::array<Chunk, numChunks> chunks;
+	ChunkQueue freeChunks, toProcess, toWrite;
+	for (int i = 0; i < numChunks; ++i) {
+		chunks[size_t (i)].audio.setSize (numChannels, blockSize);
+		freeChunks.push (i);
+	}
+	std::atomic<bool> failed { false };
+
+	// the file, then silence to flush out the latency
+	std::thread readerThread ([&] {
+		auto length = reader.lengthInSamples;
+		auto end = length + (options.align ? latency : 0);
+		int64 windowEnd = 0;
+		for (int64 position = 0; position < end && ! failed; ) {
+			auto index = freeChunks.pop ();
+			auto& chunk = chunks[size_t (index)];
+			if (position < length) {
+				if (position == windowEnd) {
+					windowEnd = jmin (position + mappedWindowFrames, length);
+					if (! reader.mapSectionOfFile (Range<int64> (position, windowEnd))) {
+						std::fprintf (stderr, "CrossFeedRender: cannot map %s\n", options.inputPath.toRawUTF8 ());
+						failed = true;
+						break;
+					}
+				}
+				chunk.numFrames = int (jmin (int64 (blockSize), windowEnd - position));
+				reader.read (&chunk.audio, 0, chunk.numFrames, position, true, true);
+			}
+			else {
+				chunk.numFrames = int (jmin (int64 (blockSize), end - position));
+				chunk.audio.clear ();
+			}
+			position += chunk.numFrames;
+			toProcess.push (index);
+		}
+		toProcess.push (ChunkQueue::endOfStream);
+	});
+
+	std::thread writerThread ([&] {
+		for (auto index = toWrite.pop (); index != ChunkQueue::endOfStream; index = toWrite.pop ()) {
+			auto& chunk = chunks[size_t (index)];
+			if (chunk.numFrames > chunk.skip && ! failed) {
+				const float* channels[] = { chunk.audio.getReadPointer (0, chunk.skip), chunk.audio.getReadPointer (1, chunk.skip) };
+				if (! writer->writeFromFloatArrays (channels, 2, chunk.numFrames - chunk.skip)) {
+					std::fprintf (stderr, "CrossFeedRender: cannot write %s\n", options.outputPath.toRawUTF8 ());
+					failed = true;
+				}
+			}
+			freeChunks.push (index);
+		}
+	});
+
+	// the processor runs on this thread
+	MidiBuffer midi;
+	int toSkip = options.align ? latency : 0;
+	int blockNumber = 0;
+	for (auto index = toProcess.pop (); index != ChunkQueue::endOfStream; index = toProcess.pop ()) {
+		auto& chunk = chunks[size_t (index)];
+		pollControlFile (processor, options, ++blockNumber);
+		AudioBuffer<float> block (chunk.audio.getArrayOfWritePointers (), numChannels, chunk.numFrames);
+		processor.processBlock (block, midi);
+		chunk.skip = jmin (toSkip, chunk.numFrames);
+		toSkip -= chunk.skip;
+		toWrite.push (index);
+	}
+	toWrite.push (ChunkQueue::endOfStream);
+
+	readerThread.join ();
+	writerThread.join ();
+	return failed ? 1 : 0;
+}
+
+// Batch rendering of a parameter grid. The input is decoded once, and read by every worker; each
+// worker owns an engine and a scratch block, and takes the next grid point until none are left, so
+// the workers share nothing that is written and scale with the number of cores.
+void copyParameters (AudioProcessor& source, AudioProcessor& destination)
+{
+	auto& from = source.getParameters ();
+	auto& to = destination.getParameters ();
+	jassert (from.size () == to.size ());
+	for (int i = 0; i < jmin (from.size (), to.size ()); ++i)
+		to[i]->setValue (from[i]->getValue ());
+}
+
+bool renderGridPoint (CrossFeedAudioProcessor& processor, const AudioBuffer<float>& input, AudioBuffer<float>& scratch,
+	AudioFormatWriter& writer, const Options& options)
+{
+	auto blockSize = scratch.getNumSamples ();
+	auto numChannels = input.getNumChannels ();
+	auto length = input.getNumSamples ();
+	int latency = processor.getLatencySamples ();
+	auto end = length + (options.align ? latency : 0);
+	int toSkip = options.align ? latency : 0;
+	MidiBuffer midi;
+
+	for (int position = 0; position < end; ) {
+		auto numFrames = jmin (blockSize, end - position);
+		AudioBuffer<float> block (scratch.getArrayOfWritePointers (), numChannels, numFrames);
+		auto numInput = jlimit (0, numFrames, length - position);
+		for (int ch = 0; ch < numChannels; ++ch) {
+			if (numInput > 0)
+				block.copyFrom (ch, 0, input, ch, position, numInput);
+			if (numInput < numFrames)
+				block.clear (ch, numInput, numFrames - numInput);
+		}
+		processor.processBlock (block, midi);
+		position += numFrames;
+
+		auto skipped = jmin (toSkip, numFrames);
+		toSkip -= skipped;
+		if (skipped < numFrames) {
+			const float* channels[] = { block.getReadPointer (0, skipped), block.getReadPointer (1, skipped) };
+			if (! writer.writeFromFloatArrays (channels, 2, numFrames - skipped))
+				return false;
+		}
+	}
+	return true;
+}
+
+int renderGrid (MemoryMappedAudioFormatReader& reader, const Options& options)
+{
+	auto numChannels = int (reader.numChannels);
+	if (reader.lengthInSamples > std::numeric_limits<int>::max () || ! reader.mapEntireFile ()) {
+		std::fprintf (stderr, "CrossFeedRender: cannot map %s\n", options.inputPath.toRawUTF8 ());
+		return 1;
+	}
+	AudioBuffer<float> input (numChannels, int (reader.lengthInSamples));
+	reader.read (&input, 0, input.getNumSamples (), 0, true, true);
+
+	File directory (File::getCurrentWorkingDirectory ().getChildFile (options.outputPath));
+	if (! directory.createDirectory ()) {
+		std::fprintf (stderr, "CrossFeedRender: cannot create %s\n", options.outputPath.toRawUTF8 ());
+		return 1;
+	}
+	auto stem = File::getCurrentWorkingDirectory ().getChildFile (options.inputPath).getFileNameWithoutExtension ();
+
+	int numPoints = 1;
+	for (auto& axis : options.grid)
+		numPoints *= int (axis.second.size ());
+	auto numWorkers = jlimit (1, jmax (1, numPoints), options.numJobs > 0 ? options.numJobs : SystemStats::getNumCpus ());
+
+	// the first engine takes the settings and control file, and the others copy its parameters, so
+	// that any warnings are printed once
+	Options workerOptions (options);
+	workerOptions.settings.clear ();
+	workerOptions.controlPath.clear ();
+	std::vector<std::unique_ptr<CrossFeedAudioProcessor>> engines;
+	for (int i = 0; i < numWorkers; ++i) {
+		engines.push_back (std::make_unique<CrossFeedAudioProcessor> ());
+		if (! prepareProcessor (*engines.back (), numChannels, reader.sampleRate, i == 0 ? options : workerOptions))
+			return 1;
+		if (i > 0)
+			copyParameters (*engines.front (), *engines.back ());
+	}
+	for (auto& axis : options.grid) {
+		if (! setParameter (*engines.front (), axis.first, axis.second.front ())) {
+			std::fprintf (stderr, "CrossFeedRender: unknown parameter %s\n", axis.first.toRawUTF8 ());
+			return 1;
+		}
+	}
+
+	std::atomic<int> nextPoint { 0 };
+	std::atomic<bool> failed { false };
+	auto work = [&](CrossFeedAudioProcessor& processor) {
+		AudioBuffer<float> scratch (numChannels, options.blockSize);
+		WavAudioFormat wav;
+		for (auto point = nextPoint++; point < numPoints && ! failed; point = nextPoint++) {
+			// the last axis varies fastest
+			String suffix;
+			for (auto axis = options.grid.size (), index = size_t (point); axis-- > 0; ) {
+				auto& values = options.grid[axis].second;
+				auto value = values[index % values.size ()];
+				index /= values.size ();
+				setParameter (processor, options.grid[axis].first, value);
+				char text[32];
+				std::snprintf (text, sizeof (text), "%g", double (value));
+				suffix = "_" + options.grid[axis].first + text + suffix;
+			}
+
+			// every point starts from rest, with its parameters already at their targets
+			processor.prepareToPlay (reader.sampleRate, options.blockSize);
+			auto outputFile = directory.getChildFile (stem + suffix + ".wav");
+			outputFile.deleteFile ();
+			std::unique_ptr<FileOutputStream> stream (outputFile.createOutputStream ());
+			std::unique_ptr<AudioFormatWriter> writer;
+			if (stream != nullptr)
+				writer.reset (wav.createWriterFor (stream.get (), reader.sampleRate, 2, int (reader.bitsPerSample), {}, 0));
+			bool written = false;
+			if (writer != nullptr) {
+				stream.release (); // now owned by the writer
+				written = renderGridPoint (processor, input, scratch, *writer, options);
+			}
+			if (! written) {
+				std::fprintf (stderr, "CrossFeedRender: cannot write %s\n", outputFile.getFullPathName ().toRawUTF8 ());
+				failed = true;
+			}
+		}
+		processor.releaseResources ();
+	};
+
+	std::vector<std::thread> workers;
+	for (int i = 1; i < numWorkers; ++i)
+		workers.emplace_back (work, std::ref (*engines[size_t (i)]));
+	work (*engines.front ());
+	for (auto& w : workers)
+		w.join ();
+	return failed ? 1 : 0;
+}
+
+} // namespace
+
+int main (int argc, char* argv[])
+{
+	StreamFormat input;
+	Options options;
+
+	for (int i = 1; i < argc; ++i) {
+		String arg (argv[i]);
+		bool hasValue = i + 1 < argc;
+		if (arg == "--format" && hasValue) {
+			String f (argv[++i]);
+			if (f == "s16") input.sampleFormat = SampleFormat::s16;
+			else if (f == "s24") input.sampleFormat = SampleFormat::s24;
+			else if (f == "s32") input.sampleFormat = SampleFormat::s32;
+			else if (f == "f32") input.sampleFormat = SampleFormat::f32;
+			else { printUsage (); return 1; }
+		}
+		else if (arg == "--rate" && hasValue) input.sampleRate = String (argv[++i]).getDoubleValue ();
+		else if (arg == "--channels" && hasValue) input.numChannels = String (argv[++i]).getIntValue ();
+		else if (arg == "--block" && hasValue) {
+			options.blockSize = String (argv[++i]).getIntValue ();
+			options.hasBlockSize = true;
+		}
+		else if (arg == "--poll" && hasValue) options.pollInterval = String (argv[++i]).getIntValue ();
+		else if (arg == "--control" && hasValue) options.controlPath = argv[++i];
+		else if (arg == "--set" && hasValue) {
+			String s (argv[++i]);
+			options.settings.emplace_back (s.upToFirstOccurrenceOf ("=", false, false), s.fromFirstOccurrenceOf ("=", false, false).getFloatValue ());
+		}
+		else if (arg == "--grid" && hasValue) {
+			std::string s (argv[++i]);
+			auto equals = s.find ('=');
+			std::vector<float> values;
+			std::istringstream list (equals == std::string::npos ? std::string () : s.substr (equals + 1));
+			for (std::string value; std::getline (list, value, ','); )
+				values.push_back (String (value).getFloatValue ());
+			if (values.empty ()) { printUsage (); return 1; }
+			options.grid.emplace_back (String (s.substr (0, equals)), values);
+		}
+		else if (arg == "--jobs" && hasValue) options.numJobs = String (argv[++i]).getIntValue ();
+		else if (arg == "--scale" && hasValue) {
+			std::istringstream list (argv[++i]);
+			for (std::string count; std::getline (list, count, ','); )
+				if (String (count).getIntValue () > 0)
+					options.instanceCounts.push_back (String (count).getIntValue ());
+			if (options.instanceCounts.empty ()) { printUsage (); return 1; }
+		}
+		else if (arg == "--automation" && hasValue) {
+			std::istringstream list (argv[++i]);
+			for (std::string size; std::getline (list, size, ','); )
+				if (String (size).getIntValue () > 0)
+					options.automationBlockSizes.push_back (String (size).getIntValue ());
+			if (options.automationBlockSizes.empty ()) { printUsage (); return 1; }
+		}
+		else if (arg == "--in" && hasValue) options.inputPath = argv[++i];
+		else if (arg == "--out" && hasValue) options.outputPath = argv[++i];
+		else if (arg == "--no-align") options.align = false;
+		else if (arg == "--verify") options.verify = true;
+		else if (arg == "--test") options.test = true;
+		else if (arg == "--stress" && hasValue) options.stressBlocks = String (argv[++i]).getLargeIntValue ();
+		else if (arg == "--budget" && hasValue) options.budget = String (argv[++i]).getDoubleValue () / 100.0;
+		else if (arg == "--seed" && hasValue) options.seed = uint32 (String (argv[++i]).getLargeIntValue ());
+		else { printUsage (); return 1; }
+	}
+
+	if (options.test)
+		return runUnitTests () == 0 ? 0 : 1;
+
+	if (! options.instanceCounts.empty ()) {
+		if (options.blockSize <= 0 || input.sampleRate <= 0) {
+			printUsage ();
+			return 1;
+		}
+		benchmarkScaling (options.instanceCounts, options.numJobs > 0 ? options.numJobs : SystemStats::getNumCpus (), input.sampleRate, options.blockSize);
+		return 0;
+	}
+
+	if (! options.automationBlockSizes.empty ()) {
+		if (input.sampleRate <= 0) {
+			printUsage ();
+			return 1;
+		}
+		benchmarkAutomation (options.automationBlockSizes, input.sampleRate);
+		return 0;
+	}
+
+	CrossFeedAudioProcessor processor;
+
+	if (options.verify) {
+		if (! prepareProcessor (processor, 2, input.sampleRate, options))
+			return 1;
+		return verifyAgainstReference (processor, input.sampleRate, options.blockSize) ? 0 : 1;
+	}
+	if (options.stressBlocks > 0) {
+		if (! prepareProcessor (processor, 2, input.sampleRate, options))
+			return 1;
+		return stressProcessor (processor, options.stressBlocks, options.budget, options.seed) ? 0 : 1;
+	}
+
+	if (options.inputPath.isNotEmpty ()) {
+		if (options.outputPath.isEmpty ()) {
+			printUsage ();
+			return 1;
+		}
+		WavAudioFormat wav;
+		std::unique_ptr<MemoryMappedAudioFormatReader> reader (wav.createMemoryMappedReader (File::getCurrentWorkingDirectory ().getChildFile (options.inputPath)));
+		if (reader == nullptr) {
+			std::fprintf (stderr, "CrossFeedRender: cannot open %s as WAV\n", options.inputPath.toRawUTF8 ());
+			return 1;
+		}
+		if (! options.grid.empty ())
+			return renderGrid (*reader, options);
+		if (! options.hasBlockSize)
+			options.blockSize = Options::fileBlockSize;
+		if (! prepareProcessor (processor, int (reader->numChannels), reader->sampleRate, options))
+			return 1;
+		auto result = renderFile (processor, *reader, options);
+		processor.releaseResources ();
+		return result;
+	}
+
+#if JUCE_WINDOWS
+	_setmode (_fileno (stdin), _O_BINARY);
+	_setmode (_fileno (stdout), _O_BINARY);
+#endif
+	std::setvbuf (stdin, inputStreamBuffer, _IOFBF, streamBufferSize);
+	std::setvbuf (stdout, outputStreamBuffer, _IOFBF, streamBufferSize);
+
+	// WAV framing is recognised from the first four bytes; otherwise they are the start of the audio
+	unsigned char prefix[4];
+	auto prefixSize = readFully (prefix, 4);
+	if (prefixSize == 4 && std::memcmp (prefix, "RIFF", 4) == 0) {
+		if (! readWavHeader (input)) {
+			std::fprintf (stderr, "CrossFeedRender: unsupported WAV input\n");
+			return 1;
+		}
+		input.isWav = true;
+		prefixSize = 0;
+	}
+
+	if (! prepareProcessor (processor, input.numChannels, input.sampleRate, options))
+		return 1;
+	auto result = renderPipe (processor, input, prefix, prefixSize, options);
+	processor.releaseResources ();
+	return result;
+}
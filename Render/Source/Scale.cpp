@@ -0,0 +1,223 @@
+/*
+  ==============================================================================
+
+	Scale.cpp
+	Created: 19 Oct 2026 7:12:31pm
+	Author:  Abhinav Natarajan
+
+  ==============================================================================
+*/
+
+#include "Scale.h"
+#include "../../Source/PluginProcessor.h"
+#include <cstdio>
+#include <numeric>
+#include <thread>
+
+namespace {
+
+constexpr double audioSecondsPerRun { 2.0 };
+
+double secondsSince (int64 startTicks)
+{
+	return Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks () - startTicks);
+}
+
+double percentile (std::vector<double>& values, double p)
+{
+	if (values.empty ())
+		return 0.0;
+	auto nth = values.begin () + std::ptrdiff_t (p * double (values.size () - 1));
+	std::nth_element (values.begin (), nth, values.end ());
+	return *nth;
+}
+
+// Runs work (thread) once on every thread, this one as thread 0, and returns when all have
+// finished: one host callback. Idle workers spin on a generation count, as real-time host threads
+// do rather than sleeping between callbacks.
+class CallbackPool {
+public:
+	CallbackPool (int numThreads, std::function<void (int)> newWork) : work (std::move (newWork)) {
+		for (int t = 1; t < numThreads; ++t)
+			threads.emplace_back ([this, t] { runWorker (t); });
+	}
+
+	~CallbackPool () {
+		quit = true;
+		for (auto& t : threads)
+			t.join ();
+	}
+
+	void run () {
+		busy = int (threads.size ());
+		++generation;
+		work (0);
+		while (busy > 0)
+			std::this_thread::yield ();
+	}
+
+private:
+	void runWorker (int thread) {
+		for (int seen = 0;;) {
+			while (generation == seen) {
+				if (quit)
+					return;
+				std::this_thread::yield ();
+			}
+			seen = generation;
+			work (thread);
+			--busy;
+		}
+	}
+
+	std::function<void (int)> work;
+	std::vector<std::thread> threads;
+	std::atomic<int> generation { 0 };
+	std::atomic<int> busy { 0 };
+	std::atomic<bool> quit { false };
+};
+
+} // namespace
+
+void benchmarkScaling (const std::vector<int>& instanceCounts, int numThreads, double sampleRate, int blockSize)
+{
+	auto numCallbacks = int (std::ceil (audioSecondsPerRun * sampleRate / blockSize));
+	auto deadline = blockSize / sampleRate;
+	Random random { 1 };
+	AudioBuffer<float> noise (2, blockSize);
+	for (int ch = 0; ch < 2; ++ch)
+		for (int i = 0; i < blockSize; ++i)
+			noise.setSample (ch, i, 0.5f * (2.0f * random.nextFloat () - 1.0f));
+
+	AudioProcessor::BusesLayout stereo;
+	stereo.inputBuses.add (AudioChannelSet::stereo ());
+	stereo.outputBuses.add (AudioChannelSet::stereo ());
+	stereo.outputBuses.add (AudioChannelSet::disabled ());
+
+	std::printf ("%d threads, %d-sample callbacks at %g Hz (deadline %.1f us)\n", numThreads, blockSize, sampleRate, deadline * 1.0e6);
+	std::printf ("%9s %12s %12s %8s %14s %14s %9s\n", "instances", "create us", "state KiB", "dsp %", "block p99 us", "callback p99", "overruns");
+	for (auto numInstances : instanceCounts) {
+		// load the session: every instance is created and prepared before any audio runs
+		std::vector<std::unique_ptr<CrossFeedAudioProcessor>> instances;
+		auto start = Time::getHighResolutionTicks ();
+		for (int i = 0; i < numInstances; ++i) {
+			instances.push_back (std::make_unique<CrossFeedAudioProcessor> ());
+			auto& p = *instances.back ();
+			p.setBusesLayout (stereo);
+			p.setRateAndBufferSizeDetails (sampleRate, blockSize);
+			p.prepareToPlay (sampleRate, blockSize);
+		}
+		auto createSeconds = secondsSince (start);
+		std::vector<AudioBuffer<float>> buffers;
+		for (int i = 0; i < numInstances; ++i)
+			buffers.emplace_back (2, blockSize);
+
+		// each thread takes the next instance until the callback's work is shared out
+		std::atomic<int> nextInstance { 0 };
+		std::vector<std::vector<double>> blockTimes (static_cast<size_t> (numThreads));
+		for (auto& times : blockTimes)
+			times.reserve (size_t (numCallbacks) * size_t (numInstances));
+		std::vector<MidiBuffer> midi (static_cast<size_t> (numThreads));
+		CallbackPool pool (numThreads, [&](int thread) {
+			for (auto i = nextInstance++; i < numInstances; i = nextInstance++) {
+				auto& buffer = buffers[size_t (i)];
+				for (int ch = 0; ch < 2; ++ch)
+					buffer.copyFrom (ch, 0, noise, ch, 0, blockSize);
+				auto blockStart = Time::getHighResolutionTicks ();
+				instances[size_t (i)]->processBlock (buffer, midi[size_t (thread)]);
+				blockTimes[size_t (thread)].push_back (secondsSince (blockStart));
+			}
+		});
+
+		std::vector<double> callbackTimes;
+		callbackTimes.reserve (size_t (numCallbacks));
+		int overruns = 0;
+		for (int c = 0; c < numCallbacks; ++c) {
+			nextInstance = 0;
+			auto callbackStart = Time::getHighResolutionTicks ();
+			pool.run ();
+			callbackTimes.push_back (secondsSince (callbackStart));
+			if (callbackTimes.back () > deadline)
+				++overruns;
+		}
+
+		std::vector<double> allBlockTimes;
+		for (auto& times : blockTimes)
+			allBlockTimes.insert (allBlockTimes.end (), times.begin (), times.end ());
+		auto dspSeconds = std::accumulate (allBlockTimes.begin (), allBlockTimes.end (), 0.0);
+		auto audioSeconds = numCallbacks * deadline;
+
+		std::printf ("%9d %12.1f %12.1f %8.1f %14.1f %14.1f %9d\n", numInstances,
+			createSeconds * 1.0e6 / numInstances,
+			instances.front ()->getStateMemoryBytes () / 1024.0,
+			100.0 * dspSeconds / audioSeconds,
+			percentile (allBlockTimes, 0.99) * 1.0e6,
+			percentile (callbackTimes, 0.99) * 1.0e6,
+			overruns);
+	}
+}
+
+void benchmarkAutomation (const std::vector<int>& blockSizes, double sampleRate)
+{
+	// one event per segment of the processor, which re-reads its parameters at every segment
+	constexpr int eventInterval { 32 };
+	auto numSamples = int (audioSecondsPerRun * sampleRate);
+	Random random { 1 };
+	AudioBuffer<float> noise (2, numSamples);
+	for (int ch = 0; ch < 2; ++ch)
+		for (int i = 0; i < numSamples; ++i)
+			noise.setSample (ch, i, 0.5f * (2.0f * random.nextFloat () - 1.0f));
+
+	AudioProcessor::BusesLayout stereo;
+	stereo.inputBuses.add (AudioChannelSet::stereo ());
+	stereo.outputBuses.add (AudioChannelSet::stereo ());
+	stereo.outputBuses.add (AudioChannelSet::disabled ());
+
+	std::printf ("%g s of stereo noise at %g Hz, one instance\n", audioSecondsPerRun, sampleRate);
+	std::printf ("%9s %14s %14s %10s %14s\n", "block", "static ns/smp", "storm ns/smp", "storm/static", "storm p99 us");
+	for (auto blockSize : blockSizes) {
+		// static: the parameters never move, so every segment takes the steady path
+		// storm: every block moves gain, crossfeed gain, angle, head width and cutoff, and a head
+		// tracker sends a yaw at every segment, so the coefficients are recomputed throughout
+		double nanosecondsPerSample[2] {};
+		std::vector<double> stormBlockTimes;
+		for (int storm = 0; storm < 2; ++storm) {
+			CrossFeedAudioProcessor processor;
+			processor.setBusesLayout (stereo);
+			processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+			*processor.headTracking = storm != 0;
+			processor.prepareToPlay (sampleRate, blockSize);
+			AudioBuffer<float> buffer (2, blockSize);
+			MidiBuffer midi;
+			midi.ensureSize (size_t (blockSize / eventInterval + 1) * 4 * sizeof (int));
+
+			double seconds = 0.0;
+			int64 processed = 0;
+			for (int start = 0; start + blockSize <= numSamples; start += blockSize) {
+				for (int ch = 0; ch < 2; ++ch)
+					buffer.copyFrom (ch, 0, noise, ch, start, blockSize);
+				midi.clear ();
+				if (storm != 0) {
+					for (auto* parameter : { processor.gaindB, processor.xGaindB, processor.angle, processor.headWidth, processor.shadowCutoff })
+						parameter->setValueNotifyingHost (random.nextFloat ());
+					for (int i = 0; i < blockSize; i += eventInterval)
+						midi.addEvent (MidiMessage::controllerEvent (1, CrossFeedAudioProcessor::yawControllerMSB, random.nextInt (128)), i);
+				}
+
+				auto blockStart = Time::getHighResolutionTicks ();
+				processor.processBlock (buffer, midi);
+				auto blockSeconds = secondsSince (blockStart);
+				seconds += blockSeconds;
+				processed += blockSize;
+				if (storm != 0)
+					stormBlockTimes.push_back (blockSeconds);
+			}
+			processor.releaseResources ();
+			nanosecondsPerSample[storm] = processed > 0 ? seconds * 1.0e9 / double (processed) : 0.0;
+		}
+
+		std::printf ("%9d %14.1f %14.1f %10.2f %14.1f\n", blockSize, nanosecondsPerSample[0], nanosecondsPerSample[1],
+			nanosecondsPerSample[0] > 0.0 ? nanosecondsPerSample[1] / nanosecondsPerSample[0] : 0.0,
+			percentile (stormBlockTimes, 0.99) * 1.0e6);
+	}
+}
@@ -0,0 +1,32 @@
+/*
+  ==============================================================================
+
+	Scale.h
+	Created: 19 Oct 2026 7:12:31pm
+	Author:  Abhinav Natarajan
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+/** Session-scale benchmark. For each count in instanceCounts, creates that many stereo
+	CrossFeedAudioProcessor instances and runs a few seconds of audio through all of them, one host
+	callback at a time, with numThreads threads sharing out the instances of each callback as a
+	multithreaded host would. Every instance reads its own noise input.
+
+	Prints, per count: instantiation time and state memory per instance, the time spent in
+	processBlock on all threads as a share of the audio time (100% is one core), and the 99th
+	percentile of single processBlock calls and of whole callbacks, whose deadline is the block's
+	duration. */
+void benchmarkScaling (const std::vector<int>& instanceCounts, int numThreads, double sampleRate, int blockSize);
+
+/** Automation benchmark. For each size in blockSizes, runs a few seconds of noise through one
+	stereo instance twice: once with its parameters static, and once in an automation storm, with
+	gain, crossfeed gain, angle, head width and cutoff moved every block and a head-tracker yaw
+	event at every 32-sample segment, so that the coefficients are recomputed all the way through.
+
+	Prints, per size: the processing time per sample of both runs, their ratio, and the 99th
+	percentile of single processBlock calls in the storm. */
+void benchmarkAutomation (const std::vector<int>& blockSizes, double sampleRate);
@@ -0,0 +1,182 @@
+/*
+  ==============================================================================
+
+	Stress.cpp
+	Created: 19 Oct 2026 6:27:50pm
+	Author:  Abhinav Natarajan
+
+  ==============================================================================
+*/
+
+#include "Stress.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Heap allocations made while insideProcessBlock is set on the calling thread. Counting them
+// means replacing the global allocation functions, for the whole of CrossFeedRender; outside
+// processBlock they cost one thread-local test. JUCE's HeapBlock and the C library allocate with
+// malloc, calloc and realloc rather than new, so on Linux those are replaced as well, passing on
+// to glibc's own entry points; free needs no counting and is left as it is. AddressSanitizer
+// replaces the same functions, so sanitized builds count new and new[] only.
+thread_local bool insideProcessBlock { false };
+std::atomic<int64> allocationsInProcessBlock { 0 };
+
+inline void countAllocation () noexcept
+{
+	if (insideProcessBlock)
+		++allocationsInProcessBlock;
+}
+
+} // namespace
+
+#if defined (__SANITIZE_ADDRESS__)
+#define CROSSFEED_HOOK_MALLOC 0
+#elif defined (__has_feature)
+#if __has_feature (address_sanitizer)
+#define CROSSFEED_HOOK_MALLOC 0
+#endif
+#endif
+#ifndef CROSSFEED_HOOK_MALLOC
+#define CROSSFEED_HOOK_MALLOC JUCE_LINUX
+#endif
+
+#if CROSSFEED_HOOK_MALLOC
+extern "C" {
+void* __libc_malloc (std::size_t);
+void* __libc_calloc (std::size_t, std::size_t);
+void* __libc_realloc (void*, std::size_t);
+
+void* malloc (std::size_t size) noexcept { countAllocation (); return __libc_malloc (size); }
+void* calloc (std::size_t count, std::size_t size) noexcept { countAllocation (); return __libc_calloc (count, size); }
+void* realloc (void* p, std::size_t size) noexcept { countAllocation (); return __libc_realloc (p, size); }
+}
+#endif
+
+namespace {
+
+void* allocate (std::size_t size)
+{
+#if ! CROSSFEED_HOOK_MALLOC
+	countAllocation (); // otherwise malloc counts it
+#endif
+	if (auto* p = std::malloc (size == 0 ? 1 : size))
+		return p;
+	throw std::bad_alloc ();
+}
+
+constexpr double sampleRates[] { 22050.0, 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 };
+constexpr int oddBlockSizes[] { 1, 7, 513 };
+constexpr int maxBlockSize { 8192 };
+// runaway output: far beyond what any setting can reach from input at -6 dBFS
+constexpr float maxOutput { 16.0f };
+
+} // namespace
+
+void* operator new (std::size_t size) { return allocate (size); }
+void* operator new[] (std::size_t size) { return allocate (size); }
+void operator delete (void* p) noexcept { std::free (p); }
+void operator delete[] (void* p) noexcept { std::free (p); }
+void operator delete (void* p, std::size_t) noexcept { std::free (p); }
+void operator delete[] (void* p, std::size_t) noexcept { std::free (p); }
+
+bool stressProcessor (CrossFeedAudioProcessor& processor, int64 numBlocks, double budget, uint32 seed)
+{
+	Random random { int64 (seed) };
+	AudioBuffer<float> buffer (2, maxBlockSize);
+	MidiBuffer midi;
+	midi.ensureSize (1024);
+	auto& parameters = processor.getParameters ();
+
+	double sampleRate = 0.0;
+	int announcedBlockSize = 0;
+	int64 blocksUntilRateChange = 0;
+	bool wasNonRealtime = processor.isNonRealtime ();
+	bool isOffline = false;
+	int numSessions = 0;
+	int64 numSamples = 0, numOfflineBlocks = 0, badSamples = 0;
+	double worstLoad = 0.0;
+	int64 overruns = 0;
+	int worstBlockSize = 0;
+	double worstSampleRate = 0.0;
+
+	for (int64 blockNumber = 0; blockNumber < numBlocks; ++blockNumber) {
+		// a new session every few thousand blocks, as when the host's device settings change
+		if (blocksUntilRateChange-- <= 0) {
+			processor.releaseResources ();
+			// three sessions in four play live; every fourth is an offline bounce in long blocks,
+			// which takes the processor's non-realtime paths instead
+			isOffline = ++numSessions % 4 == 0;
+			processor.setNonRealtime (isOffline);
+			sampleRate = sampleRates[random.nextInt (numElementsInArray (sampleRates))];
+			announcedBlockSize = isOffline ? maxBlockSize : 16 << random.nextInt (8);
+			processor.setRateAndBufferSizeDetails (sampleRate, announcedBlockSize);
+			processor.prepareToPlay (sampleRate, announcedBlockSize);
+			blocksUntilRateChange = 1000 + random.nextInt (10000);
+		}
+
+		// automation, program changes and bypass toggles land between blocks
+		for (auto changes = random.nextInt (4); --changes >= 0; ) {
+			auto* parameter = parameters[random.nextInt (parameters.size ())];
+			if (parameter != processor.bypass)
+				parameter->setValueNotifyingHost (random.nextFloat ());
+		}
+		if (random.nextInt (100) == 0)
+			processor.bypass->setValueNotifyingHost (*processor.bypass ? 0.0f : 1.0f);
+		if (random.nextInt (1000) == 0)
+			processor.setCurrentProgram (random.nextInt (processor.getNumPrograms ()));
+
+		auto blockSize = random.nextInt (4) == 0 ? oddBlockSizes[random.nextInt (numElementsInArray (oddBlockSizes))]
+			: isOffline ? maxBlockSize : 1 + random.nextInt (jmin (2 * announcedBlockSize, maxBlockSize));
+		AudioBuffer<float> block (buffer.getArrayOfWritePointers (), 2, blockSize);
+		for (int ch = 0; ch < 2; ++ch)
+			for (int i = 0; i < blockSize; ++i)
+				block.setSample (ch, i, 0.5f * (2.0f * random.nextFloat () - 1.0f));
+
+		midi.clear ();
+		if (random.nextInt (8) == 0) {
+			auto position = random.nextInt (blockSize);
+			midi.addEvent (MidiMessage::controllerEvent (1, CrossFeedAudioProcessor::yawControllerMSB, random.nextInt (128)), position);
+			midi.addEvent (MidiMessage::controllerEvent (1, CrossFeedAudioProcessor::yawControllerLSB, random.nextInt (128)), position);
+		}
+
+		auto start = Time::getHighResolutionTicks ();
+		insideProcessBlock = true;
+		processor.processBlock (block, midi);
+		insideProcessBlock = false;
+		auto seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks () - start);
+
+		// an offline bounce has no deadline to meet
+		auto load = isOffline ? 0.0 : seconds * sampleRate / blockSize;
+		numOfflineBlocks += isOffline ? 1 : 0;
+		if (budget > 0.0 && load > budget)
+			++overruns;
+		if (load > worstLoad) {
+			worstLoad = load;
+			worstBlockSize = blockSize;
+			worstSampleRate = sampleRate;
+		}
+		for (int ch = 0; ch < 2; ++ch) {
+			for (auto* x = block.getReadPointer (ch), * end = x + blockSize; x != end; ++x) {
+				if (! std::isfinite (*x) || std::abs (*x) > maxOutput)
+					++badSamples;
+			}
+		}
+		numSamples += blockSize;
+	}
+	processor.releaseResources ();
+	processor.setNonRealtime (wasNonRealtime);
+
+	auto allocations = allocationsInProcessBlock.load ();
+	auto clampedDelays = processor.getNumClampedDelays ();
+	std::printf ("%lld blocks (%lld of them offline), %lld samples\n", (long long) numBlocks, (long long) numOfflineBlocks, (long long) numSamples);
+	std::printf ("non-finite or runaway samples: %lld\n", (long long) badSamples);
+	std::printf ("allocations in processBlock:   %lld\n", (long long) allocations);
+	std::printf ("clamped delay requests:        %lld\n", (long long) clampedDelays);
+	std::printf ("worst realtime block: %d samples at %g Hz took %.1f%% of its duration\n", worstBlockSize, worstSampleRate, 100.0 * worstLoad);
+	if (budget > 0.0)
+		std::printf ("blocks over the %.1f%% budget:  %lld\n", 100.0 * budget, (long long) overruns);
+	return badSamples == 0 && allocations == 0 && clampedDelays == 0 && overruns == 0;
+}
@@ -0,0 +1,26 @@
+/*
+  ==============================================================================
+
+	Stress.h
+	Created: 19 Oct 2026 6:27:50pm
+	Author:  Abhinav Natarajan
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+/** Drives the processor the way a careless host might, for numBlocks blocks: block sizes of 1, 7,
+	513 and anything up to twice the announced size, sample rate changes, random parameter and
+	program changes, head tracking MIDI and bypass toggles, on noise at -6 dBFS. Three sessions in
+	four are realtime; every fourth is an offline bounce in 8192-sample blocks, which takes the
+	non-realtime paths. The processor must be prepared for stereo, and is left prepared at an
+	arbitrary rate, in the realtime mode it came in with.
+
+	Fails on a NaN, an infinity or a runaway output sample, on any heap allocation inside
+	processBlock, on a delay request clamped to its line, or, if budget is positive, when a
+	realtime block takes longer than that fraction of its own duration. Block times are wall
+	clock, so for a meaningful budget run on an idle machine. */
+bool stressProcessor (CrossFeedAudioProcessor& processor, int64 numBlocks, double budget, uint32 seed);
@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+	Tests.cpp
+	Created: 19 Oct 2026 9:14:06pm
+	Author:  Abhinav Natarajan
+
+  ==============================================================================
+*/
+
+#include "Tests.h"
+#include "../../Source/PluginProcessor.h"
+#include "Stress.h"
+#include "Verify.h"
+
+namespace {
+
+const String testCategory { "CrossFeed" };
+
+void prepareStereo (CrossFeedAudioProcessor& processor, double sampleRate, int blockSize)
+{
+	AudioProcessor::BusesLayout stereo;
+	stereo.inputBuses.add (AudioChannelSet::stereo ());
+	stereo.outputBuses.add (AudioChannelSet::stereo ());
+	stereo.outputBuses.add (AudioChannelSet::disabled ());
+	processor.setBusesLayout (stereo);
+	processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+	processor.prepareToPlay (sampleRate, blockSize);
+}
+
+class ReferenceTest : public UnitTest {
+public:
+	ReferenceTest () : UnitTest ("Reference corpus", testCategory) {}
+
+	void runTest () override {
+		struct Case {
+			const char* name;
+			double sampleRate;
+			int blockSize;
+			std::function<void (CrossFeedAudioProcessor&)> set;
+		};
+		const Case cases[] = {
+			{ "defaults, 44.1 kHz, 4096-sample blocks", 44100.0, 4096, [](CrossFeedAudioProcessor&) {} },
+			// blocks that end mid-segment, with the ITDs moved apart by the yaw
+			{ "head tracking, 96 kHz, 37-sample blocks", 96000.0, 37, [](CrossFeedAudioProcessor& p) {
+				*p.headTracking = true;
+				*p.headYaw = 20.0f;
+				*p.headWidth = 20.0f;
+			} },
+			{ "extremes, 48 kHz, 512-sample blocks", 48000.0, 512, [](CrossFeedAudioProcessor& p) {
+				*p.xGaindB = CrossFeedAudioProcessor::maxXGaindB;
+				*p.angle = CrossFeedAudioProcessor::maxAngle;
+				*p.headWidth = CrossFeedAudioProcessor::maxHeadWidth;
+				*p.shadowCutoff = CrossFeedAudioProcessor::maxShadowCutoff;
+			} },
+		};
+		for (auto& c : cases)
+			expectReference (c.name, c.sampleRate, c.blockSize, c.set);
+
+		// the poles nearest 1, where each shadow model is closest to its tolerance
+		for (int order = 0; order < CrossFeedAudioProcessor::numShadowOrders; ++order) {
+			if (ChainConfig::fixedShadowOrder >= 0 && order != ChainConfig::fixedShadowOrder)
+				continue;
+			expectReference ("lowest cutoff, 192 kHz, shadow order " + String (order), 192000.0, 512, [order](CrossFeedAudioProcessor& p) {
+				*p.shadowCutoff = CrossFeedAudioProcessor::minShadowCutoff;
+				if (ChainConfig::fixedShadowOrder < 0)
+					*p.shadowOrder = order;
+			});
+		}
+	}
+
+private:
+	void expectReference (const String& name, double sampleRate, int blockSize, const std::function<void (CrossFeedAudioProcessor&)>& set) {
+		beginTest (name);
+		CrossFeedAudioProcessor processor;
+		set (processor);
+		prepareStereo (processor, sampleRate, blockSize);
+		expect (verifyAgainstReference (processor, sampleRate, blockSize), "strays from the reference past its tolerance");
+	}
+};
+
+class StressTest : public UnitTest {
+public:
+	StressTest () : UnitTest ("Stress", testCategory) {}
+
+	void runTest () override {
+		beginTest ("random blocks, rates, automation and bypass");
+		CrossFeedAudioProcessor processor;
+		prepareStereo (processor, 48000.0, 512);
+		// no time budget: test machines are rarely idle
+		expect (stressProcessor (processor, 20000, 0.0, 1), "stress run failed");
+	}
+};
+
+ReferenceTest referenceTest;
+StressTest stressTest;
+
+} // namespace
+
+int runUnitTests ()
+{
+	UnitTestRunner runner;
+	runner.setAssertOnFailure (false);
+	runner.runTestsInCategory (testCategory);
+
+	int numFailures = 0;
+	for (int i = 0; i < runner.getNumResults (); ++i)
+		numFailures += runner.getResult (i)->failures;
+	return numFailures;
+}
@@ -0,0 +1,19 @@
+/*
+  ==============================================================================
+
+	Tests.h
+	Created: 19 Oct 2026 9:14:06pm
+	Author:  Abhinav Natarajan
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+/** Runs the CrossFeed unit tests: the reference corpus of verifyAgainstReference at several sample
+	rates, block sizes and settings, including the low cutoff at 192 kHz where every shadow model
+	is nearest its tolerance, then a short stressProcessor run. Each runs on a fresh stereo
+	instance. Returns the number of failed expectations, so that a build step running --test fails
+	with them. */
+int runUnitTests ();
@@ -0,0 +1,518 @@
+/*
+  ==============================================================================
+
+	Verify.cpp
+	Created: 19 Oct 2026 5:41:12pm
+	Author:  Abhinav Natarajan
+
+  ==============================================================================
+*/
+
+#include "Verify.h"
+#include <cstdio>
+#include <cstring>
+#include <deque>
+
+namespace {
+
+// Errors are counted in ULPs of full scale: the ULP of 1.0f, FLT_EPSILON or 2^-23 (-138.5 dBFS),
+// which is also one LSB of a 24-bit output. Nearer zero the spacing is finer, but an error that
+// the recursion carries from loud samples into quiet ones is no smaller for it.
+constexpr double fullScaleUlp { 1.0 / (1 << 23) };
+
+// Worst acceptable error against the reference, in ULPs of full scale. Both paths are worst where
+// the shadow pole is nearest 1 (lowest cutoff at 192 kHz): the float path's rounding is amplified
+// by the recursion, and the Q4.28 coefficient error is large next to 1 - pole. The fixed point
+// path is held to one ULP against the reference run on the coefficients it was given, so that it
+// answers for its arithmetic alone.
+constexpr double floatToleranceUlps { 24.0 };
+constexpr double fixedPointToleranceUlps { 1.0 };
+// The biquad shadow models are allowed more: their poles sit close to 1 at low cutoffs, where
+// rounding the coefficients to float moves them measurably. The worst case, a 400 Hz cutoff at
+// 192 kHz, strays by about 200 ULPs on the sweep.
+constexpr double biquadToleranceUlps { 320.0 };
+
+double getFloatToleranceUlps (int shadowOrder)
+{
+	return shadowOrder == 0 ? floatToleranceUlps : biquadToleranceUlps;
+}
+
+// The model's constants, restated rather than read from the processor so that a changed constant
+// shows up as a mismatch instead of changing both sides
+constexpr double speedOfSound { 340.0 };
+constexpr double yawShadowdB { -6.0 };
+constexpr double shadowShelfFrequency { 2000.0 };
+constexpr double shadowShelfdB { -6.0 };
+constexpr double midShelfOffsetdB { -2.0 };
+constexpr double sideShelfOffsetdB { -6.0 };
+
+// The parameter values the reference is built from
+struct ReferenceSettings {
+	double sampleRate;
+	double gaindB, xGaindB, angle, yaw, headWidth, cutoff;
+	int order;
+
+	static ReferenceSettings fromProcessor (const CrossFeedAudioProcessor& processor, double sampleRate) {
+		return { sampleRate, processor.gaindB->get (), processor.xGaindB->get (), processor.angle->get (),
+			processor.headTracking->get () ? processor.headYaw->get () : 0.0, processor.headWidth->get (),
+			processor.shadowCutoff->get (),
+			ChainConfig::fixedShadowOrder >= 0 ? ChainConfig::fixedShadowOrder : processor.shadowOrder->getIndex () };
+	}
+};
+
+// The chain written out plainly in double precision, one sample at a time, with no state arena,
+// segmenting, smoothing or crossfades, and with every coefficient and delay worked out here from
+// the parameter values: what any optimised rewrite has to agree with at rest.
+class ReferenceCrossFeed {
+public:
+	explicit ReferenceCrossFeed (const ReferenceSettings& settings) {
+		auto Fs = settings.sampleRate;
+
+		// the direct path is delayed by the group delay of the slowest model a build can select
+		size_t lpDelay = 0;
+		for (int order = 0; order < CrossFeedAudioProcessor::numShadowOrders; ++order) {
+			if (ChainConfig::fixedShadowOrder < 0 || order == ChainConfig::fixedShadowOrder)
+				lpDelay = jmax (lpDelay, toDelay (getGroupDelay (makeShadow (CrossFeedAudioProcessor::minShadowCutoff, order, Fs))));
+		}
+		shadow = makeShadow (settings.cutoff, settings.order, Fs);
+		auto shadowDelay = lpDelay - jmin (lpDelay, toDelay (getGroupDelay (shadow)));
+
+		// each ear hears the opposite speaker later and quieter, the more so the more lateral it is
+		auto headTime = settings.headWidth * 0.01 / speedOfSound;
+		auto centred = std::sin (degreesToRadians (settings.angle * 0.5));
+		double incidence[2] = { settings.angle * 0.5 - settings.yaw, settings.angle * 0.5 + settings.yaw };
+		for (size_t ear = 0; ear < 2; ++ear) {
+			auto s = std::sin (degreesToRadians (jlimit (0.0, 180.0, incidence[ear])));
+			ITDLines[ear].assign (size_t (std::floor (s * headTime * Fs)) + shadowDelay, 0.0);
+			xGains[ear] = Decibels::decibelsToGain (settings.xGaindB + yawShadowdB * (s - centred), -1000.0);
+			directLines[ear].assign (lpDelay, 0.0);
+			shadowStates[ear].assign (shadow.size (), {});
+		}
+
+		// the shelves share the pole of the single-pole lowpass, whichever model is selected
+		auto a = onePoleCoefficient (settings.cutoff / Fs);
+		auto g = Decibels::decibelsToGain (settings.xGaindB + midShelfOffsetdB, -1000.0);
+		midShelf = makeSection (1.0, a - 1.0, 0.0, 1.0 + g * a, a - 1.0, 0.0);
+		g = Decibels::decibelsToGain (settings.xGaindB + sideShelfOffsetdB, -1000.0);
+		sideShelf = makeSection (1.0, a - 1.0, 0.0, 1.0 - g * a, a - 1.0, 0.0);
+		gain = ChainConfig::hasOutputGain ? Decibels::decibelsToGain (settings.gaindB, -1000.0) : 1.0;
+	}
+
+	// The chain on the coefficients and delays the processor settled on, for checking arithmetic
+	// that is given them, as the fixed point engine is
+	explicit ReferenceCrossFeed (const FixedPointSettings& settings) {
+		auto& lp = settings.lowpass;
+		shadow = { { lp.b0, lp.b1, 0.0, lp.a1, 0.0 } };
+		for (size_t ear = 0; ear < 2; ++ear) {
+			ITDLines[ear].assign (settings.ITDs[ear], 0.0);
+			xGains[ear] = settings.xGains[ear];
+			directLines[ear].assign (settings.lpDelay, 0.0);
+			shadowStates[ear].assign (1, {});
+		}
+		midShelf = { settings.midShelf.b0, settings.midShelf.b1, 0.0, settings.midShelf.a1, 0.0 };
+		sideShelf = { settings.sideShelf.b0, settings.sideShelf.b1, 0.0, settings.sideShelf.a1, 0.0 };
+		gain = settings.gain;
+	}
+
+	void process (double& left, double& right) {
+		// crossfeed: delayed, scaled and shadowed copy of the opposite channel
+		auto crossLeft = filter (delay (ITDLines[0], right) * xGains[0], shadow, shadowStates[0]);
+		auto crossRight = filter (delay (ITDLines[1], left) * xGains[1], shadow, shadowStates[1]);
+		auto l = delay (directLines[0], left) + crossLeft;
+		auto r = delay (directLines[1], right) + crossRight;
+
+		// mid side shelves
+		if (ChainConfig::hasShelves) {
+			const auto inverseSqrtTwo = std::sqrt (0.5);
+			auto mid = filter ((l + r) * inverseSqrtTwo, midShelf, midState);
+			auto side = filter ((l - r) * inverseSqrtTwo, sideShelf, sideState);
+			l = (mid + side) * inverseSqrtTwo;
+			r = (mid - side) * inverseSqrtTwo;
+		}
+		left = l * gain;
+		right = r * gain;
+	}
+
+private:
+	// a biquad normalised by a0, first order when b2 and a2 are 0, run in transposed direct form II
+	struct Section {
+		double b0, b1, b2, a1, a2;
+	};
+	struct State {
+		double s1 { 0.0 }, s2 { 0.0 };
+	};
+
+	static Section makeSection (double b0, double b1, double b2, double a0, double a1, double a2) {
+		return { b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0 };
+	}
+
+	// pole of the single-pole lowpass whose response is 3 dB down at the normalised cutoff
+	static double onePoleCoefficient (double normalisedCutoff) {
+		auto y = 1.0 - std::cos (MathConstants<double>::twoPi * normalisedCutoff);
+		return -y + std::sqrt (y * y + 2.0 * y);
+	}
+
+	// the single-pole lowpass, a Butterworth lowpass, or that followed by a high shelf of slope 1
+	static std::vector<Section> makeShadow (double cutoff, int order, double sampleRate) {
+		if (order == 0) {
+			auto a = onePoleCoefficient (cutoff / sampleRate);
+			return { makeSection (a, 0.0, 0.0, 1.0, a - 1.0, 0.0) };
+		}
+		std::vector<Section> sections;
+		auto w = MathConstants<double>::twoPi * cutoff / sampleRate;
+		auto alpha = std::sin (w) / std::sqrt (2.0);
+		auto cosW = std::cos (w);
+		sections.push_back (makeSection ((1.0 - cosW) * 0.5, 1.0 - cosW, (1.0 - cosW) * 0.5, 1.0 + alpha, -2.0 * cosW, 1.0 - alpha));
+		if (order > 1) {
+			w = MathConstants<double>::twoPi * shadowShelfFrequency / sampleRate;
+			cosW = std::cos (w);
+			auto A = std::pow (10.0, shadowShelfdB / 40.0);
+			auto twoSqrtAAlpha = 2.0 * std::sqrt (A) * std::sin (w) / std::sqrt (2.0);
+			sections.push_back (makeSection (A * ((A + 1.0) + (A - 1.0) * cosW + twoSqrtAAlpha),
+				-2.0 * A * ((A - 1.0) + (A + 1.0) * cosW),
+				A * ((A + 1.0) + (A - 1.0) * cosW - twoSqrtAAlpha),
+				(A + 1.0) - (A - 1.0) * cosW + twoSqrtAAlpha,
+				2.0 * ((A - 1.0) - (A + 1.0) * cosW),
+				(A + 1.0) - (A - 1.0) * cosW - twoSqrtAAlpha));
+		}
+		return sections;
+	}
+
+	// group delay at DC in samples: the first moment of each polynomial over its sum
+	static double getGroupDelay (const std::vector<Section>& sections) {
+		double total = 0.0;
+		for (auto& c : sections)
+			total += (c.b1 + 2.0 * c.b2) / (c.b0 + c.b1 + c.b2) - (c.a1 + 2.0 * c.a2) / (1.0 + c.a1 + c.a2);
+		return total;
+	}
+
+	static size_t toDelay (double groupDelay) {
+		return size_t (jmax (0.0, groupDelay));
+	}
+
+	static double delay (std::deque<double>& line, double x) {
+		line.push_back (x);
+		auto y = line.front ();
+		line.pop_front ();
+		return y;
+	}
+
+	static double filter (double x, const Section& c, State& state) {
+		auto y = c.b0 * x + state.s1;
+		state.s1 = c.b1 * x - c.a1 * y + state.s2;
+		state.s2 = c.b2 * x - c.a2 * y;
+		return y;
+	}
+
+	static double filter (double x, const std::vector<Section>& sections, std::vector<State>& states) {
+		for (size_t k = 0; k < sections.size (); ++k)
+			x = filter (x, sections[k], states[k]);
+		return x;
+	}
+
+	std::deque<double> directLines[2];
+	std::deque<double> ITDLines[2];
+	double xGains[2] {};
+	std::vector<Section> shadow;
+	std::vector<State> shadowStates[2];
+	Section midShelf {}, sideShelf {};
+	State midState, sideState;
+	double gain { 1.0 };
+};
+
+// Levels leave 18 dB of headroom, so that neither path clips at the highest gain and crossfeed
+struct Stimulus {
+	const char* name;
+	std::function<void (AudioBuffer<float>&)> generate;
+};
+
+std::vector<Stimulus> makeCorpus (double sampleRate)
+{
+	return {
+		{ "silence", [](AudioBuffer<float>& b) { b.clear (); } },
+		{ "impulse left", [](AudioBuffer<float>& b) { b.clear (); b.setSample (0, 0, 0.25f); } },
+		{ "impulse right", [](AudioBuffer<float>& b) { b.clear (); b.setSample (1, 0, 0.25f); } },
+		{ "log sweep", [sampleRate](AudioBuffer<float>& b) {
+			// 20 Hz to 0.45 Fs at -18 dBFS, with an inverted half-level copy on the right
+			auto n = b.getNumSamples ();
+			auto k = std::log (0.45 * sampleRate / 20.0);
+			for (int i = 0; i < n; ++i) {
+				auto phase = MathConstants<double>::twoPi * 20.0 * n / sampleRate / k * (std::exp (k * i / n) - 1.0);
+				auto x = 0.125 * std::sin (phase);
+				b.setSample (0, i, float (x));
+				b.setSample (1, i, float (-0.5 * x));
+			}
+		} },
+		{ "white noise", [](AudioBuffer<float>& b) {
+			// uncorrelated channels peaking at -18 dBFS
+			Random random (0x5eed);
+			for (int ch = 0; ch < 2; ++ch)
+				for (int i = 0; i < b.getNumSamples (); ++i)
+					b.setSample (ch, i, 0.125f * (2.0f * random.nextFloat () - 1.0f));
+		} },
+		{ "denormal tail", [sampleRate](AudioBuffer<float>& b) {
+			// a 1 kHz tone decaying from -18 dBFS to 1e-42, well into the denormal range
+			auto n = b.getNumSamples ();
+			auto decay = std::log (1.0e-42 / 0.125) / n;
+			for (int i = 0; i < n; ++i) {
+				auto x = 0.125 * std::exp (decay * i) * std::sin (MathConstants<double>::twoPi * 1000.0 * i / sampleRate);
+				b.setSample (0, i, float (x));
+				b.setSample (1, i, float (0.7 * x));
+			}
+		} },
+	};
+}
+
+double toUlps (double error)
+{
+	return error / fullScaleUlp;
+}
+
+using ReferenceOutput = std::array<std::vector<double>, 2>;
+
+template <typename Settings>
+ReferenceOutput renderReference (const Settings& settings, const AudioBuffer<float>& input)
+{
+	ReferenceCrossFeed reference (settings);
+	ReferenceOutput output;
+	for (auto& channel : output)
+		channel.resize (size_t (input.getNumSamples ()));
+	for (int i = 0; i < input.getNumSamples (); ++i) {
+		double l = input.getSample (0, i), r = input.getSample (1, i);
+		reference.process (l, r);
+		output[0][size_t (i)] = l;
+		output[1][size_t (i)] = r;
+	}
+	return output;
+}
+
+// worst error in ULPs of full scale
+double maxError (const AudioBuffer<float>& output, const ReferenceOutput& reference)
+{
+	double error = 0.0;
+	for (int ch = 0; ch < 2; ++ch)
+		for (int i = 0; i < output.getNumSamples (); ++i)
+			error = jmax (error, std::abs (output.getSample (ch, i) - reference[size_t (ch)][size_t (i)]));
+	return toUlps (error);
+}
+
+double maxDifference (const AudioBuffer<float>& a, const AudioBuffer<float>& b)
+{
+	double error = 0.0;
+	for (int ch = 0; ch < 2; ++ch)
+		for (int i = 0; i < a.getNumSamples (); ++i)
+			error = jmax (error, std::abs (double (a.getSample (ch, i)) - b.getSample (ch, i)));
+	return toUlps (error);
+}
+
+// Renders the buffer in place through the processor, from rest, in host-sized realtime blocks,
+// calling halfway (if set) before the first block that starts past the middle
+void render (CrossFeedAudioProcessor& processor, double sampleRate, int blockSize, AudioBuffer<float>& buffer,
+	const std::function<void ()>& halfway = {})
+{
+	MidiBuffer midi;
+	processor.setNonRealtime (false);
+	processor.prepareToPlay (sampleRate, blockSize);
+	bool isPastHalfway = false;
+	for (int start = 0; start < buffer.getNumSamples (); start += blockSize) {
+		if (halfway && ! isPastHalfway && 2 * start >= buffer.getNumSamples ()) {
+			halfway ();
+			isPastHalfway = true;
+		}
+		AudioBuffer<float> block (buffer.getArrayOfWritePointers (), 2, start, jmin (blockSize, buffer.getNumSamples () - start));
+		processor.processBlock (block, midi);
+	}
+}
+
+// As render, through processInterleaved
+void renderInterleaved (CrossFeedAudioProcessor& processor, double sampleRate, int blockSize, AudioBuffer<float>& buffer)
+{
+	MidiBuffer midi;
+	auto numSamples = buffer.getNumSamples ();
+	std::vector<float> frames (2 * size_t (numSamples));
+	for (int i = 0; i < numSamples; ++i) {
+		frames[2 * size_t (i)] = buffer.getSample (0, i);
+		frames[2 * size_t (i) + 1] = buffer.getSample (1, i);
+	}
+	processor.setNonRealtime (false);
+	processor.prepareToPlay (sampleRate, blockSize);
+	for (int start = 0; start < numSamples; start += blockSize)
+		processor.processInterleaved (frames.data () + 2 * start, jmin (blockSize, numSamples - start), midi);
+	for (int i = 0; i < numSamples; ++i) {
+		buffer.setSample (0, i, frames[2 * size_t (i)]);
+		buffer.setSample (1, i, frames[2 * size_t (i) + 1]);
+	}
+}
+
+// As render, offline in one block, which the processor splits across the cores
+void renderOffline (CrossFeedAudioProcessor& processor, double sampleRate, AudioBuffer<float>& buffer)
+{
+	MidiBuffer midi;
+	processor.setNonRealtime (true);
+	processor.prepareToPlay (sampleRate, buffer.getNumSamples ());
+	processor.processBlock (buffer, midi);
+	processor.setNonRealtime (false);
+}
+
+void setDefaults (CrossFeedAudioProcessor& processor)
+{
+	*processor.gaindB = CrossFeedAudioProcessor::defaultGaindB;
+	*processor.xGaindB = CrossFeedAudioProcessor::defaultXGaindB;
+	*processor.angle = CrossFeedAudioProcessor::defaultAngle;
+	*processor.headWidth = CrossFeedAudioProcessor::defaultHeadWidth;
+	*processor.shadowCutoff = CrossFeedAudioProcessor::defaultShadowCutoff;
+	*processor.shadowOrder = CrossFeedAudioProcessor::defaultShadowOrder;
+	*processor.headTracking = false;
+	*processor.abCompare = false;
+	*processor.abSelect = false;
+}
+
+// Switching the comparison on must leave A exactly as it was, and B at its own settings must
+// render what A does at those settings, since B runs the same stages in the same order. Each
+// render moves the angle halfway through, so the ITDs crossfade and the gains ramp, where the
+// order of the stages shows. Returns the worst of the two differences, in ULPs of full scale.
+double verifyComparison (CrossFeedAudioProcessor& processor, double sampleRate, int blockSize, const AudioBuffer<float>& input)
+{
+	auto moveA = [&processor] { *processor.angle = *processor.angle + 15.0f; };
+	auto moveB = [&processor] { *processor.bAngle = *processor.bAngle + 15.0f; };
+	auto angle = processor.angle->get ();
+	AudioBuffer<float> plain, a, b;
+	plain.makeCopyOf (input);
+	render (processor, sampleRate, blockSize, plain, moveA);
+	*processor.angle = angle;
+
+	*processor.bGaindB = -3.0f;
+	*processor.bXGaindB = -7.5f;
+	*processor.bAngle = 40.0f;
+	*processor.abCompare = true;
+	*processor.abSelect = false;
+	a.makeCopyOf (input);
+	render (processor, sampleRate, blockSize, a, moveA);
+	*processor.angle = angle;
+	*processor.abSelect = true;
+	b.makeCopyOf (input);
+	render (processor, sampleRate, blockSize, b, moveB);
+	*processor.bAngle = 40.0f;
+	auto error = maxDifference (plain, a);
+
+	// A at B's settings, without the comparison
+	*processor.abCompare = false;
+	*processor.abSelect = false;
+	*processor.gaindB = *processor.bGaindB;
+	*processor.xGaindB = *processor.bXGaindB;
+	*processor.angle = *processor.bAngle;
+	plain.makeCopyOf (input);
+	render (processor, sampleRate, blockSize, plain, moveA);
+	return jmax (error, maxDifference (plain, b));
+}
+
+void printRow (const char* name, const std::vector<double>& errors, bool ok)
+{
+	std::printf ("%-16s", name);
+	for (auto e : errors) {
+		if (e < 0.0)
+			std::printf (" %12s", "-");
+		else
+			std::printf (" %12.2f", e);
+	}
+	std::printf ("%s\n", ok ? "" : "  FAIL");
+}
+
+} // namespace
+
+bool verifyAgainstReference (CrossFeedAudioProcessor& processor, double sampleRate, int blockSize)
+{
+	if (*processor.bypass || *processor.autoGain || *processor.abCompare) {
+		std::fprintf (stderr, "CrossFeedRender: verification needs bypass, auto gain and A/B off\n");
+		return false;
+	}
+
+	auto numSamples = int (sampleRate);
+	AudioBuffer<float> input (2, numSamples), output (2, numSamples);
+	std::vector<int32> left (size_t (numSamples), 0), right (size_t (numSamples), 0);
+	bool passed = true;
+	auto corpus = makeCorpus (sampleRate);
+
+	// every entry point against the reference, at the given settings
+	auto settings = ReferenceSettings::fromProcessor (processor, sampleRate);
+	std::printf ("%-16s %12s %12s %12s %12s\n", "stimulus", "blocks ULPs", "interleaved", "offline", "fixed ULPs");
+	for (auto& stimulus : corpus) {
+		stimulus.generate (input);
+		auto reference = renderReference (settings, input);
+
+		// processor, from rest, in host-sized blocks, as interleaved frames and in one offline block
+		output.makeCopyOf (input);
+		render (processor, sampleRate, blockSize, output);
+		auto blockError = maxError (output, reference);
+		output.makeCopyOf (input);
+		renderInterleaved (processor, sampleRate, blockSize, output);
+		auto interleavedError = maxError (output, reference);
+		output.makeCopyOf (input);
+		renderOffline (processor, sampleRate, output);
+		auto offlineError = maxError (output, reference);
+
+		// fixed point engine, on the same input in Q31; it only has the first order shadow model
+		double fixedError = -1.0;
+		if (settings.order == 0) {
+			auto fixedPointSettings = processor.getFixedPointSettings ();
+			FixedPointCrossFeed fixedPoint;
+			fixedPoint.prepare (jmax (fixedPointSettings.lpDelay, jmax (fixedPointSettings.ITDs[0], fixedPointSettings.ITDs[1])));
+			fixedPoint.setSettings (fixedPointSettings);
+			for (int i = 0; i < numSamples; ++i) {
+				left[size_t (i)] = int32 (jlimit (-2147483648.0, 2147483647.0, std::round (input.getSample (0, i) * 2147483648.0)));
+				right[size_t (i)] = int32 (jlimit (-2147483648.0, 2147483647.0, std::round (input.getSample (1, i) * 2147483648.0)));
+			}
+			fixedPoint.process (left.data (), right.data (), size_t (numSamples));
+			auto given = renderReference (fixedPointSettings, input);
+			fixedError = 0.0;
+			for (int i = 0; i < numSamples; ++i) {
+				fixedError = jmax (fixedError, std::abs (left[size_t (i)] / 2147483648.0 - given[0][size_t (i)]),
+					std::abs (right[size_t (i)] / 2147483648.0 - given[1][size_t (i)]));
+			}
+			fixedError = toUlps (fixedError);
+		}
+
+		auto ok = jmax (blockError, interleavedError, offlineError) <= getFloatToleranceUlps (settings.order) && fixedError <= fixedPointToleranceUlps;
+		passed = passed && ok;
+		printRow (stimulus.name, { blockError, interleavedError, offlineError, fixedError }, ok);
+	}
+
+	// then at default settings, on noise: every kernel variant a stereo build can select, with each
+	// shadow model at unity gain, where the gain stage drops out, and below it
+	for (auto& stimulus : corpus)
+		if (std::strcmp (stimulus.name, "white noise") == 0)
+			stimulus.generate (input);
+	for (int order = 0; order < CrossFeedAudioProcessor::numShadowOrders; ++order) {
+		if (ChainConfig::fixedShadowOrder >= 0 && order != ChainConfig::fixedShadowOrder)
+			continue;
+		for (auto gaindB : { 0.0f, -3.0f }) {
+			if (gaindB != 0.0f && ! ChainConfig::hasOutputGain)
+				continue;
+			setDefaults (processor);
+			*processor.shadowOrder = order;
+			*processor.gaindB = gaindB;
+			output.makeCopyOf (input);
+			render (processor, sampleRate, blockSize, output);
+			auto error = maxError (output, renderReference (ReferenceSettings::fromProcessor (processor, sampleRate), input));
+			auto ok = error <= getFloatToleranceUlps (order);
+			passed = passed && ok;
+			char name[32];
+			std::snprintf (name, sizeof (name), "order %d, %g dB", order, gaindB);
+			printRow (name, { error, -1.0, -1.0, -1.0 }, ok);
+		}
+	}
+
+	// and A/B, which leaves A at B's settings
+	setDefaults (processor);
+	auto comparisonError = verifyComparison (processor, sampleRate, blockSize, input);
+	auto ok = comparisonError <= floatToleranceUlps;
+	passed = passed && ok;
+	printRow ("A/B", { comparisonError, -1.0, -1.0, -1.0 }, ok);
+
+	std::printf ("%-16s %12.2f %12.2f %12.2f %12.2f\n", "tolerances", floatToleranceUlps, floatToleranceUlps,
+		floatToleranceUlps, fixedPointToleranceUlps);
+	std::printf ("%-16s %12.2f\n", "  biquad models", biquadToleranceUlps);
+	if (SharedResourcePointer<OfflineWorkers> ()->getNumThreads () < 2)
+		std::printf ("offline blocks ran serially: this machine has one core\n");
+	return passed;
+}
@@ -0,0 +1,26 @@
+/*
+  ==============================================================================
+
+	Verify.h
+	Created: 19 Oct 2026 5:41:12pm
+	Author:  Abhinav Natarajan
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+/** Renders a fixed corpus of stimuli (silence, impulses, a sweep, noise and a tail decaying into the
+	denormal range) through processBlock, processInterleaved and one long offline block, and compares
+	each against a double precision reference of the chain that works out its own coefficients from
+	the parameter values. The fixed point engine, which only has the first order shadow model, is
+	compared with the reference run on the coefficients it is given. Then, at default settings,
+	renders noise through every shadow model at and away from unity gain, and with the A/B
+	comparison switched on, which must leave A unchanged and render B as A renders the same settings.
+
+	The processor must be prepared for stereo, with bypass, auto gain and A/B off, and is left in an
+	arbitrary state. Prints the worst error of each path per stimulus in ULPs of full scale (2^-23),
+	and returns false if any exceeds its tolerance. */
+bool verifyAgainstReference (CrossFeedAudioProcessor& processor, double sampleRate, int blockSize);
@@ -0,0 +1,249 @@
+/*
+  ==============================================================================
+
+	Analyser.h
+	Created: 19 Oct 2026 7:48:26pm
+	Author:  Abhinav Natarajan
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Decimated stereo output of the processor, on its way to the analysis thread. The audio thread
+// only ever writes: frames that find the FIFO full are dropped rather than waited for, and nothing
+// is written at all until the editor enables the tap. It holds nothing until prepared, and then
+// only enough for the slowest reader's interval, or two blocks if those are longer.
+class MeterFifo {
+public:
+	// pairs of samples are averaged, a cheap anti-alias filter for the halved rate
+	static constexpr int decimation { 2 };
+	static constexpr int maxCapacity { 1 << 15 };
+	// readers drain at least this often: the loudness thread every 50 ms, the analyser every 15
+	static constexpr double bufferedSeconds { 0.1 };
+
+	MeterFifo () = default;
+	~MeterFifo () = default;
+
+	/** Sizes the FIFO for this rate and block size, emptying it. Never while the audio thread
+		pushes; a reader that comes along meanwhile finds it empty. */
+	void prepare (double sampleRate, int maxBlockSize) {
+		auto frames = jmax (int (sampleRate / decimation * bufferedSeconds), maxBlockSize);
+		auto newCapacity = jmin (nextPowerOfTwo (jmax (frames, 1)), int (maxCapacity));
+		const SpinLock::ScopedLockType lock (resizing);
+		if (newCapacity != fifo.getTotalSize ()) {
+			leftFrames.assign (size_t (newCapacity), 0.0f);
+			rightFrames.assign (size_t (newCapacity), 0.0f);
+			leftFrames.shrink_to_fit ();
+			rightFrames.shrink_to_fit ();
+			fifo.setTotalSize (newCapacity);
+		}
+		fifo.reset ();
+		sumLeft = sumRight = 0.0f;
+		count = 0;
+	}
+
+	int getCapacity () const noexcept { return int (leftFrames.size ()); }
+	size_t getMemoryBytes () const noexcept { return (leftFrames.capacity () + rightFrames.capacity ()) * sizeof (float); }
+
+	void setEnabled (bool shouldBeEnabled) noexcept {
+		enabled.store (shouldBeEnabled, std::memory_order_relaxed);
+	}
+
+	/** Audio thread: wait-free, and a single branch while disabled. The frames are scaled by gain,
+		which costs nothing over the averaging; a stride of 2 reads interleaved stereo. */
+	void push (const float* left, const float* right, int numSamples, float gain = 1.0f, int stride = 1) noexcept {
+		if (! enabled.load (std::memory_order_relaxed))
+			return;
+
+		int start1, size1, start2, size2;
+		fifo.prepareToWrite ((count + numSamples) / decimation, start1, size1, start2, size2);
+		int written = 0;
+		auto scale = gain / decimation;
+		for (int i = 0; i < numSamples; ++i) {
+			sumLeft += left[i * stride];
+			sumRight += right[i * stride];
+			if (++count < decimation)
+				continue;
+			if (written < size1 + size2) {
+				auto index = size_t (written < size1 ? start1 + written : start2 + written - size1);
+				leftFrames[index] = sumLeft * scale;
+				rightFrames[index] = sumRight * scale;
+				++written;
+			}
+			sumLeft = sumRight = 0.0f;
+			count = 0;
+		}
+		fifo.finishedWrite (written);
+	}
+
+	/** Analysis thread: takes up to maxFrames frames, returning how many there were. */
+	int pop (float* left, float* right, int maxFrames) noexcept {
+		const SpinLock::ScopedTryLockType lock (resizing);
+		if (! lock.isLocked ())
+			return 0;
+		int start1, size1, start2, size2;
+		fifo.prepareToRead (maxFrames, start1, size1, start2, size2);
+		std::copy_n (leftFrames.data () + start1, size1, left);
+		std::copy_n (rightFrames.data () + start1, size1, right);
+		std::copy_n (leftFrames.data () + start2, size2, left + size1);
+		std::copy_n (rightFrames.data () + start2, size2, right + size1);
+		fifo.finishedRead (size1 + size2);
+		return size1 + size2;
+	}
+
+private:
+	// one slot, which never has room, until prepared
+	AbstractFifo fifo { 1 };
+	std::vector<float> leftFrames;
+	std::vector<float> rightFrames;
+	// held by prepare while it swaps the storage, so that a reader never sees it half done
+	SpinLock resizing;
+	std::atomic<bool> enabled { false };
+	// the frame being accumulated
+	float sumLeft { 0.0f };
+	float sumRight { 0.0f };
+	int count { 0 };
+
+	JUCE_DECLARE_NON_COPYABLE (MeterFifo)
+};
+
+// Background thread that turns the contents of a MeterFifo into what the editor draws: levels,
+// correlation, goniometer points and mid and side spectra. The editor copies the latest results
+// with getSnapshot; only this thread and the message thread share the lock.
+class StereoAnalyser : private Thread {
+public:
+	static constexpr int fftOrder { 11 };
+	static constexpr int fftSize { 1 << fftOrder };
+	static constexpr int numBins { fftSize / 2 };
+	static constexpr int numGoniometerPoints { 512 };
+	static constexpr float floordB { -100.0f };
+
+	struct Snapshot {
+		float leveldB[2] { floordB, floordB };
+		// normalised correlation of left and right, from -1 (out of phase) to 1 (mono)
+		float correlation { 0.0f };
+		// most recent frames as (side, mid), oldest first
+		std::array<Point<float>, numGoniometerPoints> goniometer {};
+		std::array<float, numBins> middB {};
+		std::array<float, numBins> sidedB {};
+		// rate of the analysed frames, which sets the frequency of each bin
+		double sampleRate { 0.0 };
+	};
+
+	StereoAnalyser (MeterFifo& source, const AudioProcessor& owner) : Thread ("CrossFeed analyser"), fifo (source), processor (owner) {
+		for (auto* spectrum : { &snapshot.middB, &snapshot.sidedB, &midSpectrum, &sideSpectrum })
+			spectrum->fill (float (floordB)); // by value: C++14 has no inline variables
+		fifo.setEnabled (true);
+		startThread (3);
+	}
+
+	~StereoAnalyser () {
+		fifo.setEnabled (false);
+		stopThread (1000);
+	}
+
+	void getSnapshot (Snapshot& destination) const {
+		const ScopedLock lock (snapshotLock);
+		destination = snapshot;
+	}
+
+	/** Drains the FIFO and updates the results; called by the thread every analysisInterval ms. */
+	void analyse () {
+		auto sampleRate = processor.getSampleRate () / MeterFifo::decimation;
+		if (sampleRate <= 0.0)
+			return;
+		// the power averages follow the signal with a time constant of integrationTime
+		auto smoothing = float (1.0 - std::exp (-1.0 / (integrationTime * sampleRate)));
+
+		int numNew = 0;
+		for (int n; (n = fifo.pop (popLeft.data (), popRight.data (), popSize)) > 0; numNew += n) {
+			for (int i = 0; i < n; ++i) {
+				auto l = popLeft[size_t (i)], r = popRight[size_t (i)];
+				powerLeft += smoothing * (l * l - powerLeft);
+				powerRight += smoothing * (r * r - powerRight);
+				crossPower += smoothing * (l * r - crossPower);
+
+				auto mid = (l + r) * inverseSqrtTwo, side = (l - r) * inverseSqrtTwo;
+				midHistory[historyIndex] = mid;
+				sideHistory[historyIndex] = side;
+				historyIndex = (historyIndex + 1) % size_t (fftSize);
+			}
+		}
+		if (numNew == 0)
+			return;
+
+		Snapshot result;
+		result.sampleRate = sampleRate;
+		result.leveldB[0] = Decibels::gainToDecibels (std::sqrt (powerLeft), floordB);
+		result.leveldB[1] = Decibels::gainToDecibels (std::sqrt (powerRight), floordB);
+		auto norm = std::sqrt (powerLeft * powerRight);
+		result.correlation = norm > 1.0e-10f ? jlimit (-1.0f, 1.0f, crossPower / norm) : 0.0f;
+
+		auto oldest = historyIndex + size_t (fftSize - numGoniometerPoints);
+		for (size_t i = 0; i < size_t (numGoniometerPoints); ++i) {
+			auto index = (oldest + i) % size_t (fftSize);
+			result.goniometer[i] = { sideHistory[index], midHistory[index] };
+		}
+
+		computeSpectrum (midHistory, result.middB, midSpectrum);
+		computeSpectrum (sideHistory, result.sidedB, sideSpectrum);
+
+		const ScopedLock lock (snapshotLock);
+		snapshot = result;
+	}
+
+private:
+	static constexpr int analysisInterval { 15 };
+	static constexpr double integrationTime { 0.3 };
+	// spectra fall back by this much per update, so peaks stay readable
+	static constexpr float spectrumReleasedB { 1.5f };
+	static constexpr int popSize { 1024 };
+	static constexpr float inverseSqrtTwo { 0.70710678f };
+
+	void run () override {
+		while (! threadShouldExit ()) {
+			analyse ();
+			wait (analysisInterval);
+		}
+	}
+
+	void computeSpectrum (const std::array<float, fftSize>& history, std::array<float, numBins>& destination, std::array<float, numBins>& held) {
+		for (size_t i = 0; i < size_t (fftSize); ++i)
+			fftData[i] = history[(historyIndex + i) % size_t (fftSize)];
+		window.multiplyWithWindowingTable (fftData.data (), size_t (fftSize));
+		fft.performFrequencyOnlyForwardTransform (fftData.data ());
+
+		// a full scale sine reads 0 dB: the Hann window's coherent gain is one half
+		const auto scale = 4.0f / fftSize;
+		for (size_t bin = 0; bin < size_t (numBins); ++bin) {
+			auto dB = Decibels::gainToDecibels (fftData[bin] * scale, floordB);
+			held[bin] = jmax (dB, held[bin] - spectrumReleasedB);
+			destination[bin] = held[bin];
+		}
+	}
+
+	MeterFifo& fifo;
+	const AudioProcessor& processor;
+
+	std::array<float, popSize> popLeft {};
+	std::array<float, popSize> popRight {};
+	float powerLeft { 0.0f };
+	float powerRight { 0.0f };
+	float crossPower { 0.0f };
+	std::array<float, fftSize> midHistory {};
+	std::array<float, fftSize> sideHistory {};
+	size_t historyIndex { 0 };
+
+	dsp::FFT fft { fftOrder };
+	dsp::WindowingFunction<float> window { size_t (fftSize), dsp::WindowingFunction<float>::hann, false };
+	std::array<float, 2 * fftSize> fftData {};
+	std::array<float, numBins> midSpectrum {};
+	std::array<float, numBins> sideSpectrum {};
+
+	CriticalSection snapshotLock;
+	Snapshot snapshot;
+
+	JUCE_DECLARE_NON_COPYABLE (StereoAnalyser)
+};
@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+	AnalyserDisplay.cpp
+	Created: 19 Oct 2026 8:05:12pm
+	Author:  Abhinav Natarajan
+
+  ==============================================================================
+*/
+
+#include "AnalyserDisplay.h"
+
+//==============================================================================
+AnalyserDisplay::AnalyserDisplay (MeterFifo& fifo, const AudioProcessor& processor)
+    : analyser (fifo, processor)
+{
+    setOpaque (true);
+    startTimerHz (frameRate);
+}
+
+AnalyserDisplay::~AnalyserDisplay()
+{
+    stopTimer();
+}
+
+void AnalyserDisplay::timerCallback()
+{
+    analyser.getSnapshot (snapshot);
+    repaint();
+}
+
+//==============================================================================
+void AnalyserDisplay::paint (Graphics& g)
+{
+    g.fillAll (Colours::black);
+
+    auto area = getLocalBounds().toFloat().reduced (4.0f);
+    auto goniometerArea = area.removeFromLeft (area.getHeight());
+    area.removeFromLeft (8.0f);
+    auto meterArea = area.removeFromLeft (60.0f);
+    area.removeFromLeft (8.0f);
+
+    paintGoniometer (g, goniometerArea);
+    paintMeters (g, meterArea);
+    paintSpectrum (g, area);
+}
+
+void AnalyserDisplay::paintGoniometer (Graphics& g, Rectangle<float> area)
+{
+    auto centre = area.getCentre();
+    auto radius = 0.5f * area.getWidth();
+
+    // axes: mono on the vertical, out of phase on the horizontal, left and right on the diagonals
+    g.setColour (Colours::darkgrey);
+    g.drawEllipse (area, 1.0f);
+    g.drawLine (centre.x, area.getY(), centre.x, area.getBottom(), 1.0f);
+    g.drawLine (area.getX(), centre.y, area.getRight(), centre.y, 1.0f);
+    g.setFont (11.0f);
+    g.drawText ("L", Rectangle<float> (area.getX(), area.getY(), 14.0f, 14.0f), Justification::centred);
+    g.drawText ("R", Rectangle<float> (area.getRight() - 14.0f, area.getY(), 14.0f, 14.0f), Justification::centred);
+
+    // points as (side, mid), scaled so full scale sits on the circle; side is negated so a left
+    // only signal leans left
+    g.setColour (Colours::lightgreen.withAlpha (0.6f));
+    for (auto& point : snapshot.goniometer)
+    {
+        auto x = centre.x - radius * jlimit (-1.0f, 1.0f, point.x);
+        auto y = centre.y - radius * jlimit (-1.0f, 1.0f, point.y);
+        g.fillRect (x, y, 1.5f, 1.5f);
+    }
+}
+
+void AnalyserDisplay::paintMeters (Graphics& g, Rectangle<float> area)
+{
+    auto correlationArea = area.removeFromBottom (30.0f);
+
+    // levels over 60 dB, one bar per channel
+    g.setFont (11.0f);
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto bar = area.removeFromLeft (area.getWidth() / float (2 - channel)).reduced (3.0f, 14.0f);
+        auto fill = jlimit (0.0f, 1.0f, (snapshot.leveldB[channel] + 60.0f) / 60.0f);
+        g.setColour (Colours::darkgrey);
+        g.fillRect (bar);
+        g.setColour (snapshot.leveldB[channel] > -1.0f ? Colours::red : Colours::lightgreen);
+        g.fillRect (bar.withTop (bar.getBottom() - fill * bar.getHeight()));
+        g.setColour (Colours::white);
+        g.drawText (channel == 0 ? "L" : "R", bar.withY (bar.getBottom()).withHeight (14.0f), Justification::centred);
+    }
+
+    // correlation, from -1 on the left to +1 on the right
+    auto scale = correlationArea.reduced (0.0f, 8.0f);
+    g.setColour (Colours::darkgrey);
+    g.fillRect (scale);
+    auto x = scale.getCentreX() + 0.5f * snapshot.correlation * scale.getWidth();
+    g.setColour (snapshot.correlation < 0.0f ? Colours::orange : Colours::lightgreen);
+    g.fillRect (Rectangle<float> (jmin (x, scale.getCentreX()), scale.getY(), std::abs (x - scale.getCentreX()) + 1.0f, scale.getHeight()));
+    g.setColour (Colours::white);
+    g.drawText (String (snapshot.correlation, 2), correlationArea.withHeight (10.0f).translated (0.0f, -2.0f), Justification::centred);
+}
+
+void AnalyserDisplay::paintSpectrum (Graphics& g, Rectangle<float> area)
+{
+    // decade lines on the log frequency axis
+    g.setColour (Colours::darkgrey);
+    g.setFont (11.0f);
+    for (auto frequency : { 100.0f, 1000.0f, 10000.0f })
+    {
+        auto x = area.getX() + area.getWidth() * std::log (frequency / minFrequency) / std::log (maxFrequency / minFrequency);
+        g.drawVerticalLine (int (x), area.getY(), area.getBottom());
+        g.drawText (frequency < 1000.0f ? String (int (frequency)) : String (int (frequency / 1000.0f)) + "k",
+                    Rectangle<float> (x + 2.0f, area.getBottom() - 12.0f, 30.0f, 12.0f), Justification::left);
+    }
+    g.drawRect (area);
+
+    if (snapshot.sampleRate <= 0.0)
+        return;
+
+    g.setColour (Colours::lightblue);
+    g.strokePath (makeSpectrumPath (snapshot.middB, area), PathStrokeType (1.0f));
+    g.setColour (Colours::orange);
+    g.strokePath (makeSpectrumPath (snapshot.sidedB, area), PathStrokeType (1.0f));
+
+    g.setColour (Colours::lightblue);
+    g.drawText ("Mid", area.removeFromTop (14.0f).removeFromRight (70.0f), Justification::left);
+    g.setColour (Colours::orange);
+    g.drawText ("Side", area.removeFromTop (14.0f).removeFromRight (70.0f), Justification::left);
+}
+
+Path AnalyserDisplay::makeSpectrumPath (const std::array<float, StereoAnalyser::numBins>& dB, Rectangle<float> area) const
+{
+    // one vertex per horizontal pixel, taking the loudest bin it covers, up to the decimated
+    // signal's Nyquist frequency
+    Path path;
+    auto binWidth = float (snapshot.sampleRate) / StereoAnalyser::fftSize;
+    auto width = int (area.getWidth());
+    auto logRange = std::log (maxFrequency / minFrequency);
+    for (int px = 0; px < width; ++px)
+    {
+        auto low = minFrequency * std::exp (logRange * float (px) / float (width));
+        auto high = minFrequency * std::exp (logRange * float (px + 1) / float (width));
+        if (low >= 0.5f * float (snapshot.sampleRate))
+            break;
+        auto first = jlimit (1, StereoAnalyser::numBins - 1, int (low / binWidth));
+        auto last = jlimit (first, StereoAnalyser::numBins - 1, int (high / binWidth));
+        auto level = StereoAnalyser::floordB;
+        for (auto bin = first; bin <= last; ++bin)
+            level = jmax (level, dB[size_t (bin)]);
+
+        auto y = jmap (jlimit (-spectrumRangedB, 0.0f, level), -spectrumRangedB, 0.0f, area.getBottom(), area.getY());
+        if (px == 0)
+            path.startNewSubPath (area.getX(), y);
+        else
+            path.lineTo (area.getX() + float (px), y);
+    }
+    return path;
+}
@@ -0,0 +1,46 @@
+/*
+  ==============================================================================
+
+	AnalyserDisplay.h
+	Created: 19 Oct 2026 8:05:12pm
+	Author:  Abhinav Natarajan
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Analyser.h"
+
+//==============================================================================
+/** Goniometer, correlation and level meters and mid/side spectrum of the processor's output.
+	Analysis runs on a StereoAnalyser thread for as long as the display exists; the display only
+	repaints from its latest snapshot, at frameRate.
+*/
+class AnalyserDisplay : public Component, private Timer
+{
+public:
+	AnalyserDisplay(MeterFifo& fifo, const AudioProcessor& processor);
+	~AnalyserDisplay();
+
+	void paint(Graphics&) override;
+
+private:
+	static constexpr int frameRate { 30 };
+	static constexpr float minFrequency { 20.0f };
+	static constexpr float maxFrequency { 20000.0f };
+	static constexpr float spectrumRangedB { 80.0f };
+
+	void timerCallback() override;
+
+	void paintGoniometer(Graphics&, Rectangle<float> area);
+	void paintMeters(Graphics&, Rectangle<float> area);
+	void paintSpectrum(Graphics&, Rectangle<float> area);
+	Path makeSpectrumPath(const std::array<float, StereoAnalyser::numBins>& dB, Rectangle<float> area) const;
+
+	StereoAnalyser analyser;
+	StereoAnalyser::Snapshot snapshot;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalyserDisplay)
+};
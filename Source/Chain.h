@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+
+	Chain.h
+	Created: 19 Oct 2026 10:32:17pm
+	Author:  Abhinav Natarajan
+
+  ==============================================================================
+*/
+
+#pragma once
+
+// Fixed-configuration builds pin parts of the chain at compile time by defining these, e.g. in the
+// Projucer's preprocessor definitions; only the variants such a build can reach are compiled.
+// Stereo input only, without the surround speaker pairs:
+#ifndef CROSSFEED_STEREO_ONLY
+#define CROSSFEED_STEREO_ONLY 0
+#endif
+// Head-shadow model 0, 1 or 2 in place of the ORDER parameter, or -1 to leave it selectable:
+#ifndef CROSSFEED_SHADOW_ORDER
+#define CROSSFEED_SHADOW_ORDER -1
+#endif
+// 0 leaves out the mid and side shelves:
+#ifndef CROSSFEED_SHELVES
+#define CROSSFEED_SHELVES 1
+#endif
+// 0 leaves out the output gain stage, and with it the GAIN parameter and auto gain:
+#ifndef CROSSFEED_OUTPUT_GAIN
+#define CROSSFEED_OUTPUT_GAIN 1
+#endif
+
+namespace ChainConfig {
+	constexpr bool canBeSurround { CROSSFEED_STEREO_ONLY == 0 };
+	constexpr int fixedShadowOrder { CROSSFEED_SHADOW_ORDER };
+	constexpr bool canBeFirstOrder { fixedShadowOrder <= 0 };
+	constexpr bool canBeBiquad { fixedShadowOrder != 0 };
+	constexpr bool hasShelves { CROSSFEED_SHELVES != 0 };
+	constexpr bool hasOutputGain { CROSSFEED_OUTPUT_GAIN != 0 };
+}
+
+// What the chain's parameters are doing over a segment. Once the delays have crossfaded and the
+// gains have ramped, the chain is steady and runs on constants.
+enum class ChainMotion {
+	gliding,
+	steady,
+	// steady at an output gain of exactly 1, so the gain stage drops out
+	steadyUnity
+};
+
+// One variant of the processing chain. The processor's segment kernels are templated on it, so
+// each variant compiles to straight-line code with the stages it does not use folded away.
+template <bool isSurround, bool isBiquadShadow, ChainMotion motion>
+struct ChainPolicy {
+	// centre and LFE folding and the side and rear speaker pairs
+	static constexpr bool surround { isSurround };
+	// the biquad head-shadow cascade rather than the single-pole lowpass
+	static constexpr bool biquadShadow { isBiquadShadow };
+	// ITD crossfades and gain ramps; steady chains take the delays' single tap and constant gains
+	static constexpr bool gliding { motion == ChainMotion::gliding };
+	static constexpr bool shelves { ChainConfig::hasShelves };
+	static constexpr bool outputGain { ChainConfig::hasOutputGain && motion != ChainMotion::steadyUnity };
+};
+
+namespace ChainSelection {
+	template <bool surround, bool biquadShadow, typename Function>
+	void withMotion (ChainMotion motion, Function& function) {
+		switch (motion) {
+		case ChainMotion::gliding:
+			function (ChainPolicy<surround, biquadShadow, ChainMotion::gliding> {});
+			break;
+		case ChainMotion::steady:
+			function (ChainPolicy<surround, biquadShadow, ChainConfig::hasOutputGain ? ChainMotion::steady : ChainMotion::steadyUnity> {});
+			break;
+		case ChainMotion::steadyUnity:
+			function (ChainPolicy<surround, biquadShadow, ChainMotion::steadyUnity> {});
+			break;
+		}
+	}
+
+	template <bool surround, typename Function>
+	void withShadow (bool biquadShadow, ChainMotion motion, Function& function) {
+		if (biquadShadow)
+			withMotion<surround, ChainConfig::canBeBiquad> (motion, function);
+		else
+			withMotion<surround, ! ChainConfig::canBeFirstOrder> (motion, function);
+	}
+}
+
+/** Calls function with the ChainPolicy for the runtime state, as an empty object whose type picks
+	the variant: function (ChainPolicy<...> {}). Parts pinned by a fixed build override the state. */
+template <typename Function>
+void selectChain (bool surround, bool biquadShadow, ChainMotion motion, Function&& function) {
+	if (surround)
+		ChainSelection::withShadow<ChainConfig::canBeSurround> (biquadShadow, motion, function);
+	else
+		ChainSelection::withShadow<false> (biquadShadow, motion, function);
+}
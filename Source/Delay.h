@@ -1,7 +1,7 @@
 /*
   ==============================================================================
 
-	DelayLine.h
+	Delay.h
 	Created: 21 Mar 2020 12:59:34am
 	Author:  Abhinav Natarajan
 
@@ -11,83 +11,81 @@
 #pragma once
 //#include <cstddef> - TODO how to make available std::size_t inside the classes for private use
 #include <JuceHeader.h>
-#include <vector>
+#include <array>
 #include <cmath>
 
-template <typename Type>
-// helper class that implements a single channel delay line
-class DelayLine {
+template <typename Type, size_t capacity, size_t maxChannels = 2>
+// multichannel delay for delays with a small bound known at compile time, holding its buffers inline
+// so that nothing is allocated and every read is an offset from the object itself
+class InlineDelay {
+	static_assert (capacity > 0 && (capacity & (capacity - 1)) == 0, "The capacity must be a power of two");
+
 public:
-	DelayLine () = default;
-	~DelayLine () = default;
+	InlineDelay () = default;
+	~InlineDelay () = default;
 
-	void clear () noexcept {
-		std::fill (buffer.begin (), buffer.end (), 0);
+	/** Clears the delay lines and settles on the most recently requested delay. */
+	void reset () noexcept {
+		if (hasPendingDelay) {
+			delayInSamples = pendingDelayInSamples;
+			hasPendingDelay = false;
+		}
+		fadeRemaining = 0;
+		for (size_t chan = 0; chan < numChannels; ++chan)
+			std::fill (lines[chan].begin (), lines[chan].begin () + mask + 1, Type (0));
 		writeIndex = 0;
-		readIndex = delayInSamples;
-	}
-
-	void setSize (size_t newSize) {
-		buffer.resize (newSize);
-		clear ();
-	}
-
-	size_t inline getSize () const noexcept {
-		return buffer.size ();
-	}
-
-	void inline push (Type val) noexcept {
-		buffer[writeIndex] = val;
-		if (writeIndex == 0) writeIndex = getSize () - 1;
-		else --writeIndex;
-	}
-	inline Type get () noexcept {
-		Type val = buffer[readIndex];
-		if (readIndex == 0) readIndex = getSize () - 1;
-		else --readIndex;
-		return val;
-	}
-
-	void inline setDelayInSamples (size_t newDelayInSamples) noexcept {
-		jassert (newDelayInSamples < getSize ());
-		delayInSamples = newDelayInSamples;
-		readIndex = (writeIndex + delayInSamples) % getSize ();
 	}
 
-	size_t inline getDelayInSamples () const noexcept {
-		return delayInSamples;
+	void prepare (const juce::dsp::ProcessSpec& spec) noexcept {
+		jassert (spec.numChannels <= maxChannels);
+		numChannels = jmin (size_t (spec.numChannels), maxChannels);
+		sampleRate = static_cast <Type> (spec.sampleRate);
 	}
 
-private:
-	std::vector<Type> buffer;
-	size_t delayInSamples { 0 };
-	size_t writeIndex { 0 };
-	size_t readIndex { 0 };
-};
-
-template <typename Type>
-class Delay {
-public:
-	Delay () = default;
-	~Delay () = default;
-
-	void reset () noexcept {
-		for (auto& d : delayLines) {
-			d.clear ();
-		}
+	/** Only moves the wrap mask, so it never allocates; values beyond the capacity are clamped.
+		Call reset before processing. */
+	void setMaxDelayInSamples (size_t newMaxDelayInSamples) noexcept {
+		jassert (newMaxDelayInSamples < capacity);
+		if (newMaxDelayInSamples >= capacity)
+			++numClampedRequests;
+		maxDelayInSamples = jmin (newMaxDelayInSamples, capacity - 1);
+		// wrap at the smallest power of two that holds the delay, so low rates touch less memory
+		size_t lineSize = 1;
+		while (lineSize <= maxDelayInSamples)
+			lineSize <<= 1;
+		mask = lineSize - 1;
+		delayInSamples = jmin (delayInSamples, maxDelayInSamples);
+		pendingDelayInSamples = jmin (pendingDelayInSamples, maxDelayInSamples);
+		fadeDelayInSamples = jmin (fadeDelayInSamples, maxDelayInSamples);
+	}
+
+	size_t getMaxDelayInSamples () const noexcept {
+		return maxDelayInSamples;
 	}
 
-	void prepare (const juce::dsp::ProcessSpec& spec) {
-		delayLines.resize (spec.numChannels);
-		setMaxDelayInSamples (maxDelayInSamples);
-		sampleRate = static_cast <Type> (spec.sampleRate);
+	/** Requests for a delay or maximum delay the line could not hold, since construction. Release
+		builds clamp them silently, so test harnesses check this instead. */
+	size_t getNumClampedRequests () const noexcept {
+		return numClampedRequests;
 	}
 
+	/** Changes the delay. If a crossfade length is set the change is crossfaded from the old read
+		position, and a change requested during a crossfade is held back until that one finishes.
+		Delays beyond the maximum are clamped to it, so a bad value never reads outside the line. */
 	void inline setDelayInSamples (size_t newDelayInSamples) noexcept {
 		jassert (newDelayInSamples <= maxDelayInSamples);
-		delayInSamples = newDelayInSamples;
-		for (auto& d : delayLines) {
-			d.setDelayInSamples (delayInSamples);
+		if (newDelayInSamples > maxDelayInSamples)
+			++numClampedRequests;
+		newDelayInSamples = jmin (newDelayInSamples, maxDelayInSamples);
+		if (crossfadeLength == 0) {
+			delayInSamples = newDelayInSamples;
+		}
+		else if (fadeRemaining > 0) {
+			pendingDelayInSamples = newDelayInSamples;
+			hasPendingDelay = (newDelayInSamples != delayInSamples);
+		}
+		else if (newDelayInSamples != delayInSamples) {
+			startCrossfade (newDelayInSamples);
 		}
 	}
 
@@ -95,73 +93,139 @@ public:
 		return delayInSamples;
 	}
 
-	/** Always call after calling prepare. */
 	void setDelayInSeconds (Type newDelayInSeconds) noexcept {
-		setDelayInSamples (size_t (std::floor (newDelayInSeconds * sampleRate)));
+		setDelayInSamples (size_t (jmax (Type (0), std::floor (newDelayInSeconds * sampleRate))));
 	}
 
-	Type getDelayInSeconds () const noexcept {
-		return Type (delayInSamples / sampleRate);
+	void setCrossfadeLengthInSamples (size_t newCrossfadeLength) noexcept {
+		crossfadeLength = newCrossfadeLength;
+		crossfadeStep = crossfadeLength > 0 ? Type (1) / Type (crossfadeLength) : Type (1);
 	}
 
-	void setMaxDelayInSamples (size_t newMaxDelayInSamples) {
-		jassert (newMaxDelayInSamples < std::numeric_limits<size_t>::max ());
-		maxDelayInSamples = newMaxDelayInSamples;
-		for (auto& d : delayLines) {
-			d.setSize (maxDelayInSamples + 1); // automatically clears all delaylines
-		}
+	bool isCrossfading () const noexcept {
+		return fadeRemaining > 0;
 	}
 
-	size_t getMaxDelayInSamples () {
-		return maxDelayInSamples;
-	}
-
-	void setMaxDelayInSeconds (Type newMaxDelayInSeconds) noexcept {
-		setMaxDelayInSamples (size_t (std::ceil (newMaxDelayInSeconds * sampleRate)));
-	}
-
-	Type getMaxDelayInSeconds () const noexcept {
-		return Type (maxDelayInSamples / sampleRate);
-	}
-
-	template <typename ProcessContext>
+	/** With canCrossfade false the single tap path is compiled alone, for callers that know no
+		crossfade is running. */
+	template <bool canCrossfade = true, typename ProcessContext>
 	void process (const ProcessContext& context) noexcept {
-		if (context.isBypassed)
-			processInternal<ProcessContext, true> (context);
-		else
-			processInternal<ProcessContext, false> (context);
-	}
-
-private:
-	std::vector<DelayLine<Type>> delayLines;
-	size_t delayInSamples { 0 };
-	size_t maxDelayInSamples { 150 };
-	Type sampleRate { Type (44.1e3) };
-
-
-	template <typename ProcessContext, bool isBypassed>
-	void processInternal (const ProcessContext& context) noexcept {
-
 		static_assert (std::is_same<typename ProcessContext::SampleType, Type>::value,
-			"The sample-type of the IIR filter must match the sample-type supplied to this process callback");
+			"The sample-type of the delay must match the sample-type supplied to this process callback");
 
 		auto&& inputBlock = context.getInputBlock ();
 		auto&& outputBlock = context.getOutputBlock ();
-
-		auto numChannels = inputBlock.getNumChannels ();
-		jassert (numChannels == delayLines.size ());
-
+		jassert (inputBlock.getNumChannels () == numChannels);
 		auto numSamples = inputBlock.getNumSamples ();
 		jassert (numSamples == outputBlock.getNumSamples ());
 
+		auto fadeSamples = getFadeSamples<canCrossfade> (numSamples);
+		for (size_t chan = 0; chan < numChannels; ++chan) {
+			if (context.isBypassed)
+				processLine<canCrossfade, true> (chan, inputBlock.getChannelPointer (chan), outputBlock.getChannelPointer (chan), 1, numSamples, fadeSamples);
+			else
+				processLine<canCrossfade, false> (chan, inputBlock.getChannelPointer (chan), outputBlock.getChannelPointer (chan), 1, numSamples, fadeSamples);
+		}
+		advance<canCrossfade> (numSamples, fadeSamples);
+	}
+
+	/** Delays channel c of frames held stride samples apart at samples[c], in place; with a stride
+		of 2 that is interleaved stereo. Crossfades as process does. */
+	template <bool canCrossfade = true>
+	void processStrided (Type* samples, size_t numFrames, size_t stride) noexcept {
+		jassert (stride >= numChannels);
+		auto fadeSamples = getFadeSamples<canCrossfade> (numFrames);
+		for (size_t chan = 0; chan < numChannels; ++chan)
+			processLine<canCrossfade, false> (chan, samples + chan, samples + chan, stride, numFrames, fadeSamples);
+		advance<canCrossfade> (numFrames, fadeSamples);
+	}
+
+	/** For evaluating a long block in chunks at a steady delay: writes samples start to start +
+		numSamples of one channel of the delayed block to dst, reading the block and, before its
+		start, the line. The line is untouched, so chunks can be delayed concurrently; writeBlock
+		then moves it past the block. */
+	void readBlock (size_t chan, const Type* block, size_t start, size_t numSamples, Type* dst) const noexcept {
+		jassert (fadeRemaining == 0 && ! hasPendingDelay);
+		auto line = lines[chan].data ();
+		size_t i = 0;
+		for (; i < numSamples && start + i < delayInSamples; ++i)
+			dst[i] = line[(writeIndex + start + i - delayInSamples) & mask];
+		std::copy (block + start + i - delayInSamples, block + start + numSamples - delayInSamples, dst + i);
+	}
+
+	/** Leaves the line as processing the block would have, given every channel of the block. */
+	void writeBlock (const Type* const* block, size_t numSamples) noexcept {
+		auto numToKeep = jmin (numSamples, mask + 1);
 		for (size_t chan = 0; chan < numChannels; ++chan) {
-			auto src = inputBlock.getChannelPointer (chan);
-			auto dst = outputBlock.getChannelPointer (chan);
-			auto& d = delayLines[chan];
-			for (size_t i = 0; i < numSamples; ++i) {
-				d.push (src[i]);
-				dst[i] = isBypassed ? d.get (), src[i] : d.get ();
-			}
+			auto line = lines[chan].data ();
+			for (size_t i = numSamples - numToKeep; i < numSamples; ++i)
+				line[(writeIndex + i) & mask] = block[chan][i];
+		}
+		writeIndex = (writeIndex + numSamples) & mask;
+	}
+
+private:
+	alignas (16) std::array<std::array<Type, capacity>, maxChannels> lines {};
+	size_t mask { capacity - 1 };
+	size_t writeIndex { 0 };
+	size_t numChannels { 0 };
+	size_t delayInSamples { 0 };
+	size_t maxDelayInSamples { capacity - 1 };
+	Type sampleRate { Type (44.1e3) };
+	size_t numClampedRequests { 0 };
+
+	// crossfade between the old and new delays
+	size_t crossfadeLength { 0 };
+	Type crossfadeStep { 1 };
+	size_t fadeRemaining { 0 };
+	size_t fadeDelayInSamples { 0 };
+	size_t pendingDelayInSamples { 0 };
+	bool hasPendingDelay { false };
+
+	void startCrossfade (size_t newDelayInSamples) noexcept {
+		fadeDelayInSamples = delayInSamples;
+		delayInSamples = newDelayInSamples;
+		fadeRemaining = crossfadeLength;
+	}
+
+	template <bool canCrossfade>
+	size_t getFadeSamples (size_t numSamples) const noexcept {
+		jassert (canCrossfade || fadeRemaining == 0);
+		return canCrossfade ? jmin (numSamples, fadeRemaining) : size_t (0);
+	}
+
+	// every channel starts from the same write position, which only moves once they are all done
+	template <bool canCrossfade, bool isBypassed>
+	void processLine (size_t chan, const Type* src, Type* dst, size_t stride, size_t numSamples, size_t fadeSamples) noexcept {
+		auto line = lines[chan].data ();
+		auto w = writeIndex;
+		auto fadePosition = crossfadeLength - fadeRemaining;
+		size_t i = 0;
+		for (; i < fadeSamples; ++i, ++w) {
+			auto x = src[i * stride];
+			line[w & mask] = x;
+			auto alpha = Type (fadePosition + i + 1) * crossfadeStep;
+			auto oldVal = line[(w - fadeDelayInSamples) & mask];
+			auto newVal = line[(w - delayInSamples) & mask];
+			dst[i * stride] = isBypassed ? x : oldVal + alpha * (newVal - oldVal);
+		}
+		for (; i < numSamples; ++i, ++w) {
+			auto x = src[i * stride];
+			line[w & mask] = x;
+			auto y = line[(w - delayInSamples) & mask];
+			dst[i * stride] = isBypassed ? x : y;
+		}
+	}
+
+	template <bool canCrossfade>
+	void advance (size_t numSamples, size_t fadeSamples) noexcept {
+		writeIndex = (writeIndex + numSamples) & mask;
+		if (! canCrossfade)
+			return;
+		fadeRemaining -= fadeSamples;
+		if (fadeRemaining == 0 && hasPendingDelay) {
+			hasPendingDelay = false;
+			startCrossfade (pendingDelayInSamples);
 		}
 	}
 };
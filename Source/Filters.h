@@ -0,0 +1,473 @@
+/*
+  ==============================================================================
+
+	Filters.h
+	Created: 19 Oct 2026 10:52:37am
+	Author:  Abhinav Natarajan
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "StateArena.h"
+
+template <typename Type>
+// coefficients of a first order IIR section, normalised so that a0 = 1
+struct FirstOrderCoefficients {
+	Type b0 { 1 };
+	Type b1 { 0 };
+	Type a1 { 0 };
+
+	/** Same argument order as dsp::IIR::Coefficients (b0, b1, a0, a1). */
+	void set (Type newB0, Type newB1, Type newA0, Type newA1) noexcept {
+		jassert (newA0 != 0);
+		auto a0inv = Type (1) / newA0;
+		b0 = newB0 * a0inv;
+		b1 = newB1 * a0inv;
+		a1 = newA1 * a0inv;
+	}
+
+	/** Multiplies a response held as real and imaginary parts at n frequencies by this section's
+		response there, given cos and sin of each frequency in radians per sample. */
+	void applyToResponse (const Type* cosW, const Type* sinW, Type* re, Type* im, size_t n) const noexcept {
+		for (size_t i = 0; i < n; ++i) {
+			// (b0 + b1 z^-1) / (1 + a1 z^-1) with z^-1 = cos w - j sin w
+			auto numRe = b0 + b1 * cosW[i], numIm = -b1 * sinW[i];
+			auto denRe = Type (1) + a1 * cosW[i], denIm = -a1 * sinW[i];
+			auto scale = Type (1) / (denRe * denRe + denIm * denIm);
+			auto hRe = (numRe * denRe + numIm * denIm) * scale;
+			auto hIm = (numIm * denRe - numRe * denIm) * scale;
+			auto x = re[i];
+			re[i] = x * hRe - im[i] * hIm;
+			im[i] = x * hIm + im[i] * hRe;
+		}
+	}
+};
+
+template <typename Type>
+// multichannel first order IIR filter whose coefficients and state live in a StateArena
+class FirstOrderFilter {
+public:
+	FirstOrderFilter () = default;
+	~FirstOrderFilter () = default;
+
+	void prepare (const juce::dsp::ProcessSpec& spec) noexcept {
+		numChannels = spec.numChannels;
+	}
+
+	/** Takes the coefficients and one state variable per channel from the arena. Call after prepare,
+		and reset and set the coefficients before processing. */
+	void allocate (StateArena& arena) noexcept {
+		coefficients = arena.allocate<FirstOrderCoefficients<Type>> (1);
+		state = arena.allocate<Type> (numChannels);
+	}
+
+	/** Clears the state, keeping the coefficients. */
+	void reset () noexcept {
+		std::fill (state, state + numChannels, Type (0));
+	}
+
+	/** Sets the state of a channel as if value had been its input for ever. */
+	void prime (size_t channel, Type value) noexcept {
+		jassert (channel < numChannels);
+		auto& c = *coefficients;
+		auto y = value * (c.b0 + c.b1) / (Type (1) + c.a1);
+		state[channel] = y - c.b0 * value;
+	}
+
+	FirstOrderCoefficients<Type>& getCoefficients () noexcept {
+		return *coefficients;
+	}
+
+	const FirstOrderCoefficients<Type>& getCoefficients () const noexcept {
+		return *coefficients;
+	}
+
+	template <typename ProcessContext>
+	void process (const ProcessContext& context) noexcept {
+		static_assert (std::is_same<typename ProcessContext::SampleType, Type>::value,
+			"The sample-type of the filter must match the sample-type supplied to this process callback");
+
+		if (context.isBypassed)
+			return;
+
+		auto&& inputBlock = context.getInputBlock ();
+		auto&& outputBlock = context.getOutputBlock ();
+
+		auto numChans = inputBlock.getNumChannels ();
+		jassert (numChans <= numChannels);
+
+		auto numSamples = inputBlock.getNumSamples ();
+		jassert (numSamples == outputBlock.getNumSamples ());
+
+		// transposed direct form II, as dsp::IIR::Filter
+		auto b0 = coefficients->b0, b1 = coefficients->b1, a1 = coefficients->a1;
+		for (size_t chan = 0; chan < numChans; ++chan) {
+			auto src = inputBlock.getChannelPointer (chan);
+			auto dst = outputBlock.getChannelPointer (chan);
+			auto s = state[chan];
+			for (size_t i = 0; i < numSamples; ++i) {
+				auto x = src[i];
+				auto y = b0 * x + s;
+				s = b1 * x - a1 * y;
+				dst[i] = y;
+			}
+			JUCE_SNAP_TO_ZERO (s);
+			state[chan] = s;
+		}
+	}
+
+	/** Filters channel c of frames held stride samples apart at samples[c], in place; with a stride
+		of 2 that is interleaved stereo, both channels advancing together through each frame. */
+	void processStrided (Type* samples, size_t numFrames, size_t stride) noexcept {
+		jassert (numChannels <= 2 && stride >= numChannels);
+		auto b0 = coefficients->b0, b1 = coefficients->b1, a1 = coefficients->a1;
+		Type s[2] = { state[0], numChannels > 1 ? state[1] : Type (0) };
+		for (size_t i = 0; i < numFrames; ++i, samples += stride) {
+			for (size_t chan = 0; chan < numChannels; ++chan) {
+				auto x = samples[chan];
+				auto y = b0 * x + s[chan];
+				s[chan] = b1 * x - a1 * y;
+				samples[chan] = y;
+			}
+		}
+		for (size_t chan = 0; chan < numChannels; ++chan) {
+			JUCE_SNAP_TO_ZERO (s[chan]);
+			state[chan] = s[chan];
+		}
+	}
+
+	// Per-channel access for evaluating a long block in chunks, as ChunkScan does
+
+	size_t getStateSize () const noexcept {
+		return 1;
+	}
+
+	void getState (size_t channel, Type* s) const noexcept {
+		s[0] = state[channel];
+	}
+
+	void setState (size_t channel, const Type* s) noexcept {
+		state[channel] = s[0];
+	}
+
+	/** Filters numSamples of one channel from the state s, leaving s at the end of them. The
+		filter's own state is untouched, so chunks of a block can be filtered concurrently. */
+	void processChannel (const Type* src, Type* dst, size_t numSamples, Type* s) const noexcept {
+		auto b0 = coefficients->b0, b1 = coefficients->b1, a1 = coefficients->a1;
+		auto v = s[0];
+		for (size_t i = 0; i < numSamples; ++i) {
+			auto x = src[i];
+			auto y = b0 * x + v;
+			v = b1 * x - a1 * y;
+			dst[i] = y;
+		}
+		s[0] = v;
+	}
+
+	/** Adds to dst the response to the state s with no input, stopping once it has died away. */
+	void addStateResponse (Type* dst, size_t numSamples, Type* s) const noexcept {
+		auto pole = -coefficients->a1;
+		auto v = s[0];
+		auto negligible = std::abs (v) * negligibleResponse;
+		for (size_t i = 0; i < numSamples && std::abs (v) > negligible; ++i) {
+			dst[i] += v;
+			v *= pole;
+		}
+	}
+
+private:
+	// far below the rounding of the output, relative to the state the response starts from
+	static constexpr Type negligibleResponse { Type (1.0e-10) };
+
+	FirstOrderCoefficients<Type>* coefficients { nullptr };
+	Type* state { nullptr };
+	size_t numChannels { 1 };
+};
+
+template <typename Type>
+// coefficients of a biquad section, normalised so that a0 = 1
+struct BiquadCoefficients {
+	Type b0 { 1 };
+	Type b1 { 0 };
+	Type b2 { 0 };
+	Type a1 { 0 };
+	Type a2 { 0 };
+
+	/** Same argument order as dsp::IIR::Coefficients (b0, b1, b2, a0, a1, a2). */
+	void set (Type newB0, Type newB1, Type newB2, Type newA0, Type newA1, Type newA2) noexcept {
+		jassert (newA0 != 0);
+		auto a0inv = Type (1) / newA0;
+		b0 = newB0 * a0inv;
+		b1 = newB1 * a0inv;
+		b2 = newB2 * a0inv;
+		a1 = newA1 * a0inv;
+		a2 = newA2 * a0inv;
+	}
+
+	/** Group delay at DC in samples, for aligning the filtered path with an unfiltered one. */
+	Type getDCGroupDelay () const noexcept {
+		return (b1 + Type (2) * b2) / (b0 + b1 + b2) - (a1 + Type (2) * a2) / (Type (1) + a1 + a2);
+	}
+
+	/** Multiplies a response held as real and imaginary parts at n frequencies by this section's
+		response there, given cos and sin of each frequency in radians per sample. */
+	void applyToResponse (const Type* cosW, const Type* sinW, Type* re, Type* im, size_t n) const noexcept {
+		for (size_t i = 0; i < n; ++i) {
+			// z^-2 = cos 2w - j sin 2w, from the double angle formulae
+			auto cos2W = Type (2) * cosW[i] * cosW[i] - Type (1), sin2W = Type (2) * sinW[i] * cosW[i];
+			auto numRe = b0 + b1 * cosW[i] + b2 * cos2W, numIm = -(b1 * sinW[i] + b2 * sin2W);
+			auto denRe = Type (1) + a1 * cosW[i] + a2 * cos2W, denIm = -(a1 * sinW[i] + a2 * sin2W);
+			auto scale = Type (1) / (denRe * denRe + denIm * denIm);
+			auto hRe = (numRe * denRe + numIm * denIm) * scale;
+			auto hIm = (numIm * denRe - numRe * denIm) * scale;
+			auto x = re[i];
+			re[i] = x * hRe - im[i] * hIm;
+			im[i] = x * hIm + im[i] * hRe;
+		}
+	}
+};
+
+// A left and a right sample side by side, so that a stereo recursion runs as one: the low half of
+// an SSE register or a NEON pair for float, and two scalars otherwise.
+template <typename Type>
+struct StereoLanes {
+	Type left, right;
+
+	static StereoLanes load (const Type* pair) noexcept { return { pair[0], pair[1] }; }
+	static StereoLanes load (const Type* l, const Type* r) noexcept { return { *l, *r }; }
+	static StereoLanes broadcast (Type value) noexcept { return { value, value }; }
+	void store (Type* pair) const noexcept { pair[0] = left; pair[1] = right; }
+	void store (Type* l, Type* r) const noexcept { *l = left; *r = right; }
+
+	StereoLanes operator+ (StereoLanes other) const noexcept { return { left + other.left, right + other.right }; }
+	StereoLanes operator- (StereoLanes other) const noexcept { return { left - other.left, right - other.right }; }
+	StereoLanes operator* (StereoLanes other) const noexcept { return { left * other.left, right * other.right }; }
+};
+
+#if JUCE_USE_SIMD && (defined (__SSE2__) || defined (_M_X64) || defined (_M_AMD64))
+template <>
+struct StereoLanes<float> {
+	__m128 v;
+
+	static StereoLanes load (const float* pair) noexcept { return { _mm_loadl_pi (_mm_setzero_ps (), reinterpret_cast<const __m64*> (pair)) }; }
+	static StereoLanes load (const float* l, const float* r) noexcept { return { _mm_unpacklo_ps (_mm_load_ss (l), _mm_load_ss (r)) }; }
+	static StereoLanes broadcast (float value) noexcept { return { _mm_set1_ps (value) }; }
+	void store (float* pair) const noexcept { _mm_storel_pi (reinterpret_cast<__m64*> (pair), v); }
+	void store (float* l, float* r) const noexcept {
+		_mm_store_ss (l, v);
+		_mm_store_ss (r, _mm_shuffle_ps (v, v, _MM_SHUFFLE (1, 1, 1, 1)));
+	}
+
+	StereoLanes operator+ (StereoLanes other) const noexcept { return { _mm_add_ps (v, other.v) }; }
+	StereoLanes operator- (StereoLanes other) const noexcept { return { _mm_sub_ps (v, other.v) }; }
+	StereoLanes operator* (StereoLanes other) const noexcept { return { _mm_mul_ps (v, other.v) }; }
+};
+#elif JUCE_USE_SIMD && (defined (__ARM_NEON__) || defined (__ARM_NEON))
+template <>
+struct StereoLanes<float> {
+	float32x2_t v;
+
+	static StereoLanes load (const float* pair) noexcept { return { vld1_f32 (pair) }; }
+	static StereoLanes load (const float* l, const float* r) noexcept { return { vld1_lane_f32 (r, vld1_dup_f32 (l), 1) }; }
+	static StereoLanes broadcast (float value) noexcept { return { vdup_n_f32 (value) }; }
+	void store (float* pair) const noexcept { vst1_f32 (pair, v); }
+	void store (float* l, float* r) const noexcept {
+		vst1_lane_f32 (l, v, 0);
+		vst1_lane_f32 (r, v, 1);
+	}
+
+	StereoLanes operator+ (StereoLanes other) const noexcept { return { vadd_f32 (v, other.v) }; }
+	StereoLanes operator- (StereoLanes other) const noexcept { return { vsub_f32 (v, other.v) }; }
+	StereoLanes operator* (StereoLanes other) const noexcept { return { vmul_f32 (v, other.v) }; }
+};
+#endif
+
+template <typename Type, size_t maxSections>
+// stereo cascade of up to maxSections biquads whose coefficients and state live in a StateArena
+class BiquadCascade {
+public:
+	BiquadCascade () = default;
+	~BiquadCascade () = default;
+
+	/** Takes the coefficients and the state of every section from the arena. Reset and set the
+		coefficients before processing. */
+	void allocate (StateArena& arena) noexcept {
+		coefficients = arena.allocate<BiquadCoefficients<Type>> (maxSections);
+		state = arena.allocate<Type> (maxSections * 4);
+	}
+
+	/** Clears the state, keeping the coefficients. */
+	void reset () noexcept {
+		std::fill (state, state + maxSections * 4, Type (0));
+	}
+
+	/** Sets the state of a channel as if value had been its input for ever. */
+	void prime (size_t channel, Type value) noexcept {
+		jassert (channel < 2);
+		for (size_t k = 0; k < numSections; ++k) {
+			auto& c = coefficients[k];
+			auto y = value * (c.b0 + c.b1 + c.b2) / (Type (1) + c.a1 + c.a2);
+			state[4 * k + channel] = y - c.b0 * value;
+			state[4 * k + 2 + channel] = c.b2 * value - c.a2 * y;
+			value = y;
+		}
+	}
+
+	void setNumSections (size_t newNumSections) noexcept {
+		jassert (newNumSections <= maxSections);
+		numSections = jmin (newNumSections, maxSections);
+	}
+
+	size_t getNumSections () const noexcept {
+		return numSections;
+	}
+
+	BiquadCoefficients<Type>& getCoefficients (size_t section) noexcept {
+		jassert (section < maxSections);
+		return coefficients[section];
+	}
+
+	template <typename ProcessContext>
+	void process (const ProcessContext& context) noexcept {
+		static_assert (std::is_same<typename ProcessContext::SampleType, Type>::value,
+			"The sample-type of the filter must match the sample-type supplied to this process callback");
+
+		if (context.isBypassed)
+			return;
+
+		auto&& inputBlock = context.getInputBlock ();
+		auto&& outputBlock = context.getOutputBlock ();
+		jassert (inputBlock.getNumChannels () == 2);
+
+		auto numSamples = inputBlock.getNumSamples ();
+		jassert (numSamples == outputBlock.getNumSamples ());
+
+		auto srcL = inputBlock.getChannelPointer (0);
+		auto srcR = inputBlock.getChannelPointer (1);
+		auto dstL = outputBlock.getChannelPointer (0);
+		auto dstR = outputBlock.getChannelPointer (1);
+		processFrames (numSamples,
+			[srcL, srcR](size_t i) { return StereoLanes<Type>::load (srcL + i, srcR + i); },
+			[dstL, dstR](size_t i, StereoLanes<Type> y) { y.store (dstL + i, dstR + i); });
+	}
+
+	/** Filters interleaved stereo frames in place, the left sample of frame i at frames[2 i]. */
+	void processInterleaved (Type* frames, size_t numFrames) noexcept {
+		// a frame is already the pair of lanes, so it loads and stores whole
+		processFrames (numFrames,
+			[frames](size_t i) { return StereoLanes<Type>::load (frames + 2 * i); },
+			[frames](size_t i, StereoLanes<Type> y) { y.store (frames + 2 * i); });
+	}
+
+	// Per-channel access for evaluating a long block in chunks, as ChunkScan does; the state of a
+	// channel is held as the two state variables of each section in turn
+
+	size_t getStateSize () const noexcept {
+		return 2 * numSections;
+	}
+
+	void getState (size_t channel, Type* s) const noexcept {
+		for (size_t k = 0; k < numSections; ++k) {
+			s[2 * k] = state[4 * k + channel];
+			s[2 * k + 1] = state[4 * k + 2 + channel];
+		}
+	}
+
+	void setState (size_t channel, const Type* s) noexcept {
+		for (size_t k = 0; k < numSections; ++k) {
+			state[4 * k + channel] = s[2 * k];
+			state[4 * k + 2 + channel] = s[2 * k + 1];
+		}
+	}
+
+	/** As FirstOrderFilter::processChannel. */
+	void processChannel (const Type* src, Type* dst, size_t numSamples, Type* s) const noexcept {
+		for (size_t i = 0; i < numSamples; ++i) {
+			auto x = src[i];
+			for (size_t k = 0; k < numSections; ++k) {
+				auto& c = coefficients[k];
+				auto y = c.b0 * x + s[2 * k];
+				s[2 * k] = c.b1 * x - c.a1 * y + s[2 * k + 1];
+				s[2 * k + 1] = c.b2 * x - c.a2 * y;
+				x = y;
+			}
+			dst[i] = x;
+		}
+	}
+
+	/** As FirstOrderFilter::addStateResponse; the state is checked every few samples, as the
+		response of a section can ring through zero. */
+	void addStateResponse (Type* dst, size_t numSamples, Type* s) const noexcept {
+		auto size = getStateSize ();
+		Type peak (0);
+		for (size_t r = 0; r < size; ++r)
+			peak = jmax (peak, std::abs (s[r]));
+		auto negligible = peak * negligibleResponse;
+
+		for (size_t start = 0; start < numSamples && peak > negligible; start += checkInterval) {
+			auto end = jmin (numSamples, start + checkInterval);
+			for (size_t i = start; i < end; ++i) {
+				Type x (0);
+				for (size_t k = 0; k < numSections; ++k) {
+					auto& c = coefficients[k];
+					auto y = c.b0 * x + s[2 * k];
+					s[2 * k] = c.b1 * x - c.a1 * y + s[2 * k + 1];
+					s[2 * k + 1] = c.b2 * x - c.a2 * y;
+					x = y;
+				}
+				dst[i] += x;
+			}
+			peak = Type (0);
+			for (size_t r = 0; r < size; ++r)
+				peak = jmax (peak, std::abs (s[r]));
+		}
+	}
+
+private:
+	// transposed direct form II on StereoLanes: both channels move through every section together,
+	// one vector operation serving the pair, so the second channel rides in the other lane of the
+	// first's recursion instead of adding a chain of its own
+	template <typename Load, typename Store>
+	void processFrames (size_t numFrames, Load load, Store store) noexcept {
+		using Lanes = StereoLanes<Type>;
+		Lanes b0[maxSections], b1[maxSections], b2[maxSections], a1[maxSections], a2[maxSections];
+		Lanes s1[maxSections], s2[maxSections];
+		for (size_t k = 0; k < numSections; ++k) {
+			auto& c = coefficients[k];
+			b0[k] = Lanes::broadcast (c.b0);
+			b1[k] = Lanes::broadcast (c.b1);
+			b2[k] = Lanes::broadcast (c.b2);
+			a1[k] = Lanes::broadcast (c.a1);
+			a2[k] = Lanes::broadcast (c.a2);
+			s1[k] = Lanes::load (state + 4 * k);
+			s2[k] = Lanes::load (state + 4 * k + 2);
+		}
+
+		for (size_t i = 0; i < numFrames; ++i) {
+			auto x = load (i);
+			for (size_t k = 0; k < numSections; ++k) {
+				auto y = b0[k] * x + s1[k];
+				s1[k] = b1[k] * x - a1[k] * y + s2[k];
+				s2[k] = b2[k] * x - a2[k] * y;
+				x = y;
+			}
+			store (i, x);
+		}
+
+		for (size_t k = 0; k < numSections; ++k) {
+			s1[k].store (state + 4 * k);
+			s2[k].store (state + 4 * k + 2);
+		}
+		for (size_t i = 0; i < 4 * numSections; ++i)
+			JUCE_SNAP_TO_ZERO (state[i]);
+	}
+
+	static constexpr Type negligibleResponse { Type (1.0e-10) };
+	static constexpr size_t checkInterval { 16 };
+
+	BiquadCoefficients<Type>* coefficients { nullptr };
+	Type* state { nullptr };
+	size_t numSections { 0 };
+};
@@ -0,0 +1,205 @@
+/*
+  ==============================================================================
+
+	Loudness.h
+	Created: 19 Oct 2026 9:20:44pm
+	Author:  Abhinav Natarajan
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "Analyser.h"
+#include "Filters.h"
+
+// One background thread shared by the loudness matchers of every instance in the process.
+class LoudnessThread : public TimeSliceThread {
+public:
+	LoudnessThread () : TimeSliceThread ("CrossFeed loudness") { startThread (3); }
+	~LoudnessThread () { stopThread (1000); }
+};
+
+// Estimates the loudness of the processor's input and output and publishes the makeup gain that
+// matches them, so that crossfeed can be compared with bypass at equal loudness. The audio thread
+// only pushes into the two FIFOs while the processing is fully on, neither bypassed nor fading,
+// and reads getMakeupGain; the K-weighting and averaging run on the shared LoudnessThread.
+// Offline renders outrun that thread, so while the processor is non-realtime the render thread
+// owns the estimator instead and runs it through update, between pushes of at most
+// getMaxFramesPerUpdate frames. setOffline hands the estimator over, waiting out the background
+// thread's current pass if it is in one; after that neither thread takes a lock.
+//
+// Loudness follows ITU-R BS.1770: K-weighted power summed over the channels, here averaged
+// exponentially over about the 3 s of its short-term loudness and frozen below the absolute gate,
+// so that pauses and fade-outs leave the gain alone. Surround input is matched on its front pair
+// alone.
+class LoudnessMatcher : private TimeSliceClient {
+public:
+	static constexpr float maxMakeupdB { 12.0f };
+
+	LoudnessMatcher (const AudioProcessor& owner, const AudioParameterBool& enabledParameter)
+		: processor (owner), enabled (enabledParameter) {
+		thread->addTimeSliceClient (this);
+	}
+
+	~LoudnessMatcher () {
+		thread->removeTimeSliceClient (this);
+	}
+
+	// front pair of the input, before processing
+	MeterFifo input;
+	// output, after processing
+	MeterFifo output;
+
+	/** Sizes both FIFOs, from prepareToPlay. */
+	void prepare (double sampleRate, int maxBlockSize) {
+		input.prepare (sampleRate, maxBlockSize);
+		output.prepare (sampleRate, maxBlockSize);
+	}
+
+	size_t getMemoryBytes () const noexcept { return input.getMemoryBytes () + output.getMemoryBytes (); }
+
+	/** Frames to push between offline updates, filling half a FIFO after decimation. */
+	int getMaxFramesPerUpdate () const noexcept { return input.getCapacity (); }
+
+	/** Linear gain that would bring the output to the loudness of the input; 1 while disabled. */
+	float getMakeupGain () const noexcept { return makeupGain.load (std::memory_order_relaxed); }
+
+	/** Hands the estimator to the render thread (true) or back to the background thread (false),
+		from the processor's setNonRealtime. Handing it over waits until the background thread is
+		out of its pass; neither call may overlap update. */
+	void setOffline (bool shouldBeOffline) noexcept {
+		if (! shouldBeOffline) {
+			owner.store (backgroundIdle);
+			return;
+		}
+		for (auto expected = backgroundIdle; ! owner.compare_exchange_weak (expected, renderThread); expected = backgroundIdle) {
+			if (expected == renderThread)
+				return;
+			Thread::yield ();
+		}
+	}
+
+	bool isOffline () const noexcept { return owner.load (std::memory_order_relaxed) == renderThread; }
+
+	/** Takes in whatever the FIFOs hold and updates the makeup gain, on the calling thread. Only
+		while offline, when the render thread owns the estimator. */
+	void update () {
+		jassert (isOffline ());
+		run ();
+	}
+
+private:
+	static constexpr int activeInterval { 50 };
+	static constexpr int idleInterval { 250 };
+	static constexpr double integrationTime { 3.0 };
+	// -70 LUFS, as mean square after K-weighting
+	static constexpr double gatePower { 1.0e-7 * 1.1724 };
+	static constexpr int popSize { 1024 };
+
+	// K-weighting of one stereo signal: the high shelf standing in for the head, then the RLB highpass
+	struct Meter {
+		std::array<BiquadCoefficients<double>, 2> stages;
+		std::array<std::array<double, 4>, 2> state {};
+		double power { 0.0 };
+
+		void prepare (double sampleRate) {
+			// BS.1770 prefilters, redesigned for this rate from their analogue prototypes
+			auto K = std::tan (MathConstants<double>::pi * 1681.974450955533 / sampleRate);
+			auto Q = 0.7071752369554196;
+			auto Vh = std::pow (10.0, 3.999843853973347 / 20.0);
+			auto Vb = std::pow (Vh, 0.4996667741545416);
+			stages[0].set (Vh + Vb * K / Q + K * K, 2.0 * (K * K - Vh), Vh - Vb * K / Q + K * K,
+				1.0 + K / Q + K * K, 2.0 * (K * K - 1.0), 1.0 - K / Q + K * K);
+			K = std::tan (MathConstants<double>::pi * 38.13547087602444 / sampleRate);
+			Q = 0.5003270373238773;
+			stages[1].set (1.0, -2.0, 1.0, 1.0 + K / Q + K * K, 2.0 * (K * K - 1.0), 1.0 - K / Q + K * K);
+			reset ();
+		}
+
+		void reset () {
+			for (auto& s : state)
+				s.fill (0.0);
+			power = 0.0;
+		}
+
+		double filter (size_t channel, double x) noexcept {
+			// transposed direct form II, two state variables per stage
+			auto* s = state[channel].data ();
+			for (auto& c : stages) {
+				auto y = c.b0 * x + s[0];
+				s[0] = c.b1 * x - c.a1 * y + s[1];
+				s[1] = c.b2 * x - c.a2 * y;
+				x = y;
+				s += 2;
+			}
+			return x;
+		}
+
+		void update (MeterFifo& fifo, std::array<float, popSize>& left, std::array<float, popSize>& right, double smoothing) {
+			for (int n; (n = fifo.pop (left.data (), right.data (), popSize)) > 0;) {
+				for (size_t i = 0; i < size_t (n); ++i) {
+					auto l = filter (0, left[i]), r = filter (1, right[i]);
+					power += smoothing * (l * l + r * r - power);
+				}
+			}
+		}
+	};
+
+	int useTimeSlice () override {
+		auto expected = backgroundIdle;
+		if (! owner.compare_exchange_strong (expected, backgroundRunning))
+			return idleInterval;
+		auto interval = run ();
+		owner.store (backgroundIdle);
+		return interval;
+	}
+
+	int run () {
+		bool isEnabled = enabled.get ();
+		input.setEnabled (isEnabled);
+		output.setEnabled (isEnabled);
+		auto sampleRate = processor.getSampleRate () / MeterFifo::decimation;
+		if (! isEnabled || sampleRate <= 0.0) {
+			// start afresh next time, without whatever was left in the FIFOs
+			wasRunning = false;
+			makeupGain.store (1.0f, std::memory_order_relaxed);
+			return idleInterval;
+		}
+
+		if (! wasRunning || sampleRate != meterRate) {
+			meterRate = sampleRate;
+			inputMeter.prepare (sampleRate);
+			outputMeter.prepare (sampleRate);
+			while (input.pop (popLeft.data (), popRight.data (), popSize) > 0 || output.pop (popLeft.data (), popRight.data (), popSize) > 0) {}
+			wasRunning = true;
+		}
+
+		auto smoothing = 1.0 - std::exp (-1.0 / (integrationTime * sampleRate));
+		inputMeter.update (input, popLeft, popRight, smoothing);
+		outputMeter.update (output, popLeft, popRight, smoothing);
+		if (inputMeter.power > gatePower && outputMeter.power > gatePower) {
+			auto makeupdB = float (10.0 * std::log10 (inputMeter.power / outputMeter.power));
+			makeupGain.store (Decibels::decibelsToGain (jlimit (-maxMakeupdB, maxMakeupdB, makeupdB)), std::memory_order_relaxed);
+		}
+		return activeInterval;
+	}
+
+	const AudioProcessor& processor;
+	const AudioParameterBool& enabled;
+	SharedResourcePointer<LoudnessThread> thread;
+	// which thread may run the estimator: the background thread, between or during its passes,
+	// or the render thread while the processor is non-realtime
+	enum Owner { backgroundIdle, backgroundRunning, renderThread };
+	std::atomic<Owner> owner { backgroundIdle };
+
+	Meter inputMeter;
+	Meter outputMeter;
+	double meterRate { 0.0 };
+	bool wasRunning { false };
+	std::array<float, popSize> popLeft {};
+	std::array<float, popSize> popRight {};
+	std::atomic<float> makeupGain { 1.0f };
+
+	JUCE_DECLARE_NON_COPYABLE (LoudnessMatcher)
+};
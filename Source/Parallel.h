@@ -0,0 +1,226 @@
+/*
+  ==============================================================================
+
+	Parallel.h
+	Created: 19 Oct 2026 11:47:05pm
+	Author:  Abhinav Natarajan
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Worker threads shared by every instance in the process, for spreading one long offline block
+// over the cores. One instance has them at a time; any other runs its tasks on its own thread
+// meanwhile, as it would have without them, so nothing ever waits for another instance.
+class OfflineWorkers {
+public:
+	static constexpr int maxThreads { 64 };
+
+	OfflineWorkers () {
+		auto numWorkers = jmin (SystemStats::getNumCpus (), maxThreads) - 1;
+		for (int i = 0; i < numWorkers; ++i) {
+			workers.push_back (std::make_unique<Worker> (*this));
+			workers.back ()->startThread ();
+		}
+	}
+
+	~OfflineWorkers () {
+		for (auto& w : workers)
+			w->stopThread (1000);
+	}
+
+	/** Threads that run's tasks are spread over, including the caller's. */
+	int getNumThreads () const noexcept { return int (workers.size ()) + 1; }
+
+	/** Calls task (i) for every i below numTasks, in any order and on any of the threads, and
+		returns once they have all finished. */
+	template <typename Function>
+	void run (int numTasks, Function& task) {
+		const ScopedTryLock lock (busy);
+		if (! lock.isLocked () || workers.empty () || numTasks < 2) {
+			ScopedNoDenormals noDenormals;
+			for (int i = 0; i < numTasks; ++i)
+				task (i);
+			return;
+		}
+
+		invoke = [](void* context, int index) { (*static_cast<Function*> (context)) (index); };
+		context = &task;
+		numTasksToRun = numTasks;
+		nextTask.store (0);
+		numBusy.store (int (workers.size ()));
+		for (auto& w : workers)
+			w->notify ();
+		runTasks ();
+		// every worker has left runTasks before the next batch can start
+		finished.wait ();
+	}
+
+private:
+	class Worker : public Thread {
+	public:
+		explicit Worker (OfflineWorkers& pool) : Thread ("CrossFeed offline"), owner (pool) {}
+
+		void run () override {
+			while (! threadShouldExit ()) {
+				wait (-1);
+				if (threadShouldExit ())
+					return;
+				owner.runTasks ();
+				if (--owner.numBusy == 0)
+					owner.finished.signal ();
+			}
+		}
+
+	private:
+		OfflineWorkers& owner;
+	};
+
+	void runTasks () noexcept {
+		ScopedNoDenormals noDenormals;
+		for (int i; (i = nextTask++) < numTasksToRun; )
+			invoke (context, i);
+	}
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	CriticalSection busy;
+	WaitableEvent finished;
+
+	// the batch being run
+	void (*invoke) (void*, int) { nullptr };
+	void* context { nullptr };
+	int numTasksToRun { 0 };
+	std::atomic<int> nextTask { 0 };
+	std::atomic<int> numBusy { 0 };
+
+	JUCE_DECLARE_NON_COPYABLE (OfflineWorkers)
+};
+
+// A long block cut into numChunks nearly equal pieces, the last taking the remainder.
+struct BlockChunks {
+	size_t numSamples { 0 };
+	size_t chunkLength { 0 };
+	int numChunks { 0 };
+
+	BlockChunks (size_t length, int maxChunks, size_t minChunkLength) noexcept
+		: numSamples (length), numChunks (jmax (1, jmin (maxChunks, int (length / jmax (size_t (1), minChunkLength))))) {
+		chunkLength = numSamples / size_t (numChunks);
+	}
+
+	size_t getStart (int chunk) const noexcept { return size_t (chunk) * chunkLength; }
+	size_t getLength (int chunk) const noexcept { return chunk == numChunks - 1 ? numSamples - getStart (chunk) : chunkLength; }
+};
+
+// Runs a linear recurrence (a FirstOrderFilter or BiquadCascade) over a long block in chunks that
+// are filtered concurrently. Each chunk is first filtered from rest, which is wrong only by the
+// response to the state it should have started in. The true start states follow in a serial scan
+// over the chunks, s[k + 1] = e[k] + A^L s[k], where e[k] is the state chunk k ended in from rest
+// and A^L the transition over a chunk of L samples; then each chunk adds the response to its start
+// state, which dies away within a few time constants, again concurrently.
+//
+//	scan.prepare (filter, chunks);
+//	workers.run: scan.filterChunk (filter, channel, chunk, src, dst) for every channel
+//	scan.resolve (filter, numChannels);
+//	workers.run: scan.correctChunk (filter, channel, chunk, dst) for every channel
+template <typename Type, size_t maxStateSize, size_t maxChannels = 2>
+class ChunkScan {
+public:
+	static constexpr int maxChunks { OfflineWorkers::maxThreads };
+
+	/** Sets up the transitions for the filter's current coefficients and these chunks. */
+	template <typename Filter>
+	void prepare (const Filter& filter, const BlockChunks& newChunks) noexcept {
+		jassert (newChunks.numChunks <= maxChunks);
+		chunks = newChunks;
+		stateSize = filter.getStateSize ();
+		jassert (stateSize <= maxStateSize);
+
+		// column i of the one step transition is where the unit state i goes on a zero input
+		Matrix step {};
+		for (size_t i = 0; i < stateSize; ++i) {
+			std::array<Type, maxStateSize> s {};
+			s[i] = Type (1);
+			Type zero (0), y;
+			filter.processChannel (&zero, &y, 1, s.data ());
+			for (size_t r = 0; r < stateSize; ++r)
+				step[r][i] = double (s[r]);
+		}
+		chunkTransition = power (step, chunks.chunkLength);
+		lastTransition = power (step, chunks.getLength (chunks.numChunks - 1));
+	}
+
+	/** Filters one chunk of one channel from rest, keeping the state it ends in. */
+	template <typename Filter>
+	void filterChunk (const Filter& filter, size_t channel, int chunk, const Type* src, Type* dst) noexcept {
+		auto& s = ends[channel][size_t (chunk)];
+		s.fill (Type (0));
+		filter.processChannel (src, dst, chunks.getLength (chunk), s.data ());
+	}
+
+	/** Works out the state every chunk should have started in, from the filter's state before
+		the block, and leaves the filter in the state after it. */
+	template <typename Filter>
+	void resolve (Filter& filter, size_t numChannels) noexcept {
+		jassert (numChannels <= maxChannels);
+		for (size_t chan = 0; chan < numChannels; ++chan) {
+			auto& s = starts[chan];
+			filter.getState (chan, s[0].data ());
+			for (int k = 0; k < chunks.numChunks; ++k) {
+				auto& A = k == chunks.numChunks - 1 ? lastTransition : chunkTransition;
+				auto& from = s[size_t (k)];
+				auto& to = s[size_t (k) + 1];
+				for (size_t r = 0; r < stateSize; ++r) {
+					auto sum = double (ends[chan][size_t (k)][r]);
+					for (size_t c = 0; c < stateSize; ++c)
+						sum += A[r][c] * double (from[c]);
+					to[r] = Type (sum);
+				}
+			}
+			auto& last = s[size_t (chunks.numChunks)];
+			for (size_t r = 0; r < stateSize; ++r)
+				JUCE_SNAP_TO_ZERO (last[r]);
+			filter.setState (chan, last.data ());
+		}
+	}
+
+	/** Adds the response to the chunk's true start state to its output from rest. */
+	template <typename Filter>
+	void correctChunk (const Filter& filter, size_t channel, int chunk, Type* dst) const noexcept {
+		auto s = starts[channel][size_t (chunk)];
+		filter.addStateResponse (dst, chunks.getLength (chunk), s.data ());
+	}
+
+private:
+	using Matrix = std::array<std::array<double, maxStateSize>, maxStateSize>;
+
+	Matrix multiply (const Matrix& a, const Matrix& b) const noexcept {
+		Matrix result {};
+		for (size_t r = 0; r < stateSize; ++r)
+			for (size_t k = 0; k < stateSize; ++k)
+				for (size_t c = 0; c < stateSize; ++c)
+					result[r][c] += a[r][k] * b[k][c];
+		return result;
+	}
+
+	// by repeated squaring, in double so that long chunks do not pile up rounding
+	Matrix power (Matrix base, size_t exponent) const noexcept {
+		Matrix result {};
+		for (size_t i = 0; i < stateSize; ++i)
+			result[i][i] = 1.0;
+		for (; exponent > 0; exponent >>= 1) {
+			if (exponent & 1)
+				result = multiply (result, base);
+			base = multiply (base, base);
+		}
+		return result;
+	}
+
+	BlockChunks chunks { 0, 1, 1 };
+	size_t stateSize { 0 };
+	Matrix chunkTransition {};
+	Matrix lastTransition {};
+	std::array<std::array<std::array<Type, maxStateSize>, maxChunks>, maxChannels> ends {};
+	std::array<std::array<std::array<Type, maxStateSize>, maxChunks + 1>, maxChannels> starts {};
+};
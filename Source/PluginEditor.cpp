@@ -3,10 +3,10 @@
 
 //==============================================================================
 CrossFeedAudioProcessorEditor::CrossFeedAudioProcessorEditor (CrossFeedAudioProcessor& p)
-    : AudioProcessorEditor (&p), processor (p)
+    : AudioProcessorEditor (&p), processor (p), responseDisplay (p), analyserDisplay (p.meterFifo, p)
 {
     // editor size
-    setSize (550, 180);
+    setSize (550, 770);
 
     // gain slider params
     addAndMakeVisible (&gainSlider);
@@ -14,7 +14,6 @@ CrossFeedAudioProcessorEditor::CrossFeedAudioProcessorEditor (CrossFeedAudioProc
     gainSlider.setRange (processor.minGaindB, processor.maxGaindB);
     gainSlider.setTextValueSuffix (" dB");
     gainSlider.setNumDecimalPlacesToDisplay (1);
-    gainSlider.setValue (processor.defaultGaindB);
     gainSlider.setDoubleClickReturnValue (true, processor.defaultGaindB);
     gainSlider.addListener (this);
 
@@ -29,7 +28,6 @@ CrossFeedAudioProcessorEditor::CrossFeedAudioProcessorEditor (CrossFeedAudioProc
     xGainSlider.setRange(processor.minXGaindB, processor.maxXGaindB);
     xGainSlider.setTextValueSuffix(" dB");
     xGainSlider.setNumDecimalPlacesToDisplay(1);
-    xGainSlider.setValue(processor.defaultXGaindB);
     xGainSlider.setDoubleClickReturnValue(true, processor.defaultXGaindB);
     xGainSlider.addListener(this);
 
@@ -44,7 +42,6 @@ CrossFeedAudioProcessorEditor::CrossFeedAudioProcessorEditor (CrossFeedAudioProc
     angleSlider.setRange(processor.minAngle, processor.maxAngle, 1);
     angleSlider.setNumDecimalPlacesToDisplay(0);
     angleSlider.setTextValueSuffix(" deg");
-    angleSlider.setValue(processor.defaultAngle);
     angleSlider.setDoubleClickReturnValue(true, processor.defaultAngle);
     angleSlider.addListener(this);
 
@@ -53,14 +50,140 @@ CrossFeedAudioProcessorEditor::CrossFeedAudioProcessorEditor (CrossFeedAudioProc
     angleLabel.setText("Angle", dontSendNotification);
     angleLabel.attachToComponent(&angleSlider, true);
 
+    // head yaw slider params
+    addAndMakeVisible(&yawSlider);
+    yawSlider.setSliderStyle(Slider::LinearHorizontal);
+    yawSlider.setRange(processor.minYaw, processor.maxYaw, 0.1);
+    yawSlider.setNumDecimalPlacesToDisplay(1);
+    yawSlider.setTextValueSuffix(" deg");
+    yawSlider.setDoubleClickReturnValue(true, processor.defaultYaw);
+    yawSlider.addListener(this);
+
+    // head yaw label
+    addAndMakeVisible(&yawLabel);
+    yawLabel.setText("Head Yaw", dontSendNotification);
+    yawLabel.attachToComponent(&yawSlider, true);
+
+    // head width slider params
+    addAndMakeVisible(&widthSlider);
+    widthSlider.setSliderStyle(Slider::LinearHorizontal);
+    widthSlider.setRange(processor.minHeadWidth, processor.maxHeadWidth, 0.1);
+    widthSlider.setNumDecimalPlacesToDisplay(1);
+    widthSlider.setTextValueSuffix(" cm");
+    widthSlider.setDoubleClickReturnValue(true, processor.defaultHeadWidth);
+    widthSlider.addListener(this);
+
+    // head width label
+    addAndMakeVisible(&widthLabel);
+    widthLabel.setText("Head Width", dontSendNotification);
+    widthLabel.attachToComponent(&widthSlider, true);
+
+    // shadow cutoff slider params
+    addAndMakeVisible(&cutoffSlider);
+    cutoffSlider.setSliderStyle(Slider::LinearHorizontal);
+    cutoffSlider.setRange(processor.minShadowCutoff, processor.maxShadowCutoff, 1);
+    cutoffSlider.setSkewFactor(0.5);
+    cutoffSlider.setNumDecimalPlacesToDisplay(0);
+    cutoffSlider.setTextValueSuffix(" Hz");
+    cutoffSlider.setDoubleClickReturnValue(true, processor.defaultShadowCutoff);
+    cutoffSlider.addListener(this);
+
+    // shadow cutoff label
+    addAndMakeVisible(&cutoffLabel);
+    cutoffLabel.setText("Shadow", dontSendNotification);
+    cutoffLabel.attachToComponent(&cutoffSlider, true);
+
+    // B's gain, crossfeed gain and angle, which A/B renders alongside A's
+    addAndMakeVisible(&bGainSlider);
+    bGainSlider.setSliderStyle(Slider::LinearHorizontal);
+    bGainSlider.setRange(processor.minGaindB, processor.maxGaindB);
+    bGainSlider.setTextValueSuffix(" dB");
+    bGainSlider.setNumDecimalPlacesToDisplay(1);
+    bGainSlider.setDoubleClickReturnValue(true, processor.defaultGaindB);
+    bGainSlider.addListener(this);
+    addAndMakeVisible(&bGainLabel);
+    bGainLabel.setText("B Gain", dontSendNotification);
+    bGainLabel.attachToComponent(&bGainSlider, true);
+
+    addAndMakeVisible(&bXGainSlider);
+    bXGainSlider.setSliderStyle(Slider::LinearHorizontal);
+    bXGainSlider.setRange(processor.minXGaindB, processor.maxXGaindB);
+    bXGainSlider.setTextValueSuffix(" dB");
+    bXGainSlider.setNumDecimalPlacesToDisplay(1);
+    bXGainSlider.setDoubleClickReturnValue(true, processor.defaultXGaindB);
+    bXGainSlider.addListener(this);
+    addAndMakeVisible(&bXGainLabel);
+    bXGainLabel.setText("B Crossfeed", dontSendNotification);
+    bXGainLabel.attachToComponent(&bXGainSlider, true);
+
+    addAndMakeVisible(&bAngleSlider);
+    bAngleSlider.setSliderStyle(Slider::LinearHorizontal);
+    bAngleSlider.setRange(processor.minAngle, processor.maxAngle, 1);
+    bAngleSlider.setNumDecimalPlacesToDisplay(0);
+    bAngleSlider.setTextValueSuffix(" deg");
+    bAngleSlider.setDoubleClickReturnValue(true, processor.defaultAngle);
+    bAngleSlider.addListener(this);
+    addAndMakeVisible(&bAngleLabel);
+    bAngleLabel.setText("B Angle", dontSendNotification);
+    bAngleLabel.attachToComponent(&bAngleSlider, true);
+
+    // head shadow model selector
+    addAndMakeVisible(shadowOrderBox);
+    shadowOrderBox.addItemList(processor.shadowOrder->choices, 1);
+    shadowOrderBox.addListener(this);
+
     // bypass button
     addAndMakeVisible(bypassButton);
     bypassButton.setButtonText("Bypass");
     bypassButton.addListener(this);
+
+    // head tracking button
+    addAndMakeVisible(trackingButton);
+    trackingButton.setButtonText("Head Tracking");
+    trackingButton.addListener(this);
+
+    // auto gain button
+    addAndMakeVisible(autoGainButton);
+    autoGainButton.setButtonText("Auto Gain");
+    autoGainButton.addListener(this);
+
+    // A/B comparison: B renders alongside A with its own gain, crossfeed and angle
+    addAndMakeVisible(compareButton);
+    compareButton.setButtonText("A/B");
+    compareButton.addListener(this);
+    addAndMakeVisible(selectBButton);
+    selectBButton.setButtonText("Hear B");
+    selectBButton.addListener(this);
+    addAndMakeVisible(copyAToBButton);
+    copyAToBButton.setButtonText("Copy A to B");
+    copyAToBButton.addListener(this);
+
+    // fixed-configuration builds have no controls for the stages they leave out
+    gainSlider.setVisible(ChainConfig::hasOutputGain);
+    gainLabel.setVisible(ChainConfig::hasOutputGain);
+    bGainSlider.setVisible(ChainConfig::hasOutputGain);
+    bGainLabel.setVisible(ChainConfig::hasOutputGain);
+    autoGainButton.setVisible(ChainConfig::hasOutputGain);
+    shadowOrderBox.setVisible(ChainConfig::fixedShadowOrder < 0);
+
+    // response of the chain, computed from the parameters
+    addAndMakeVisible(responseDisplay);
+
+    // output meters, analysed off the audio thread
+    addAndMakeVisible(analyserDisplay);
+
+    // every control shows its parameter's current value, and follows it from here on
+    updateControls();
+    for (auto* parameter : processor.getParameters())
+        parameter->addListener(this);
+    startTimerHz(pollRate);
 }
 
 CrossFeedAudioProcessorEditor::~CrossFeedAudioProcessorEditor()
 {
+    stopTimer();
+    for (auto* parameter : processor.getParameters())
+        parameter->removeListener(this);
 }
 
 //==============================================================================
@@ -80,26 +203,113 @@ void CrossFeedAudioProcessorEditor::resized()
     gainSlider.setBounds(left, 20, getWidth() - left - 10, 20);
     xGainSlider.setBounds(left, 50, getWidth() - left - 10, 20);
     angleSlider.setBounds(left, 80, getWidth() - left - 10, 20);
-    bypassButton.setBounds(left, 110, 120, 20);
+    yawSlider.setBounds(left, 110, getWidth() - left - 10, 20);
+    widthSlider.setBounds(left, 140, getWidth() - left - 10, 20);
+    cutoffSlider.setBounds(left, 170, getWidth() - left - 10, 20);
+    bypassButton.setBounds(left, 200, 90, 20);
+    trackingButton.setBounds(left + 100, 200, 120, 20);
+    autoGainButton.setBounds(left + 230, 200, 100, 20);
+    shadowOrderBox.setBounds(left + 340, 200, 120, 20);
+    compareButton.setBounds(left, 230, 90, 20);
+    selectBButton.setBounds(left + 100, 230, 120, 20);
+    copyAToBButton.setBounds(left + 230, 230, 100, 20);
+    bGainSlider.setBounds(left, 260, getWidth() - left - 10, 20);
+    bXGainSlider.setBounds(left, 290, getWidth() - left - 10, 20);
+    bAngleSlider.setBounds(left, 320, getWidth() - left - 10, 20);
+    responseDisplay.setBounds(10, 355, getWidth() - 20, 170);
+    analyserDisplay.setBounds(10, 535, getWidth() - 20, 225);
 }
 
-void CrossFeedAudioProcessorEditor::sliderValueChanged(Slider* slider)
+AudioParameterFloat* CrossFeedAudioProcessorEditor::getParameter(Slider* slider) const
 {
     if (slider == &gainSlider)
+        return processor.gaindB;
+    if (slider == &xGainSlider)
+        return processor.xGaindB;
+    if (slider == &angleSlider)
+        return processor.angle;
+    if (slider == &yawSlider)
+        return processor.headYaw;
+    if (slider == &widthSlider)
+        return processor.headWidth;
+    if (slider == &cutoffSlider)
+        return processor.shadowCutoff;
+    if (slider == &bGainSlider)
+        return processor.bGaindB;
+    if (slider == &bXGainSlider)
+        return processor.bXGaindB;
+    jassert (slider == &bAngleSlider);
+    return processor.bAngle;
+}
+
+AudioParameterBool* CrossFeedAudioProcessorEditor::getParameter(Button* button) const
+{
+    if (button == &bypassButton)
+        return processor.bypass;
+    if (button == &trackingButton)
+        return processor.headTracking;
+    if (button == &autoGainButton)
+        return processor.autoGain;
+    if (button == &compareButton)
+        return processor.abCompare;
+    if (button == &selectBButton)
+        return processor.abSelect;
+    return nullptr;
+}
+
+void CrossFeedAudioProcessorEditor::updateControls()
+{
+    for (auto* slider : { &gainSlider, &xGainSlider, &angleSlider, &yawSlider, &widthSlider, &cutoffSlider,
+                          &bGainSlider, &bXGainSlider, &bAngleSlider })
+        slider->setValue(getParameter(slider)->get(), dontSendNotification);
+    for (auto* button : { &bypassButton, &trackingButton, &autoGainButton, &compareButton, &selectBButton })
+        button->setToggleState(getParameter(button)->get(), dontSendNotification);
+    shadowOrderBox.setSelectedItemIndex(processor.shadowOrder->getIndex(), dontSendNotification);
+}
+
+void CrossFeedAudioProcessorEditor::parameterValueChanged(int, float)
+{
+    parametersChanged = true;
+}
+
+void CrossFeedAudioProcessorEditor::timerCallback()
+{
+    if (parametersChanged.exchange(false))
+        updateControls();
+}
+
+void CrossFeedAudioProcessorEditor::sliderValueChanged(Slider* slider)
+{
+    *getParameter(slider) = float(slider->getValue());
+}
+
+void CrossFeedAudioProcessorEditor::sliderDragStarted(Slider* slider)
+{
+    getParameter(slider)->beginChangeGesture();
+}
+
+void CrossFeedAudioProcessorEditor::sliderDragEnded(Slider* slider)
+{
+    getParameter(slider)->endChangeGesture();
+}
+
+void CrossFeedAudioProcessorEditor::buttonClicked(Button* button)
+{
+    if (button == &copyAToBButton)
     {
-        *processor.gaindB = gainSlider.getValue();
-    }
-    else if (slider == &xGainSlider)
-    {
-        *processor.xGaindB = xGainSlider.getValue();
+        processor.copyAToB();
     }
-    else
+    else if (auto* parameter = getParameter(button))
     {
-        *processor.angle = angleSlider.getValue();
+        parameter->beginChangeGesture();
+        *parameter = button->getToggleState();
+        parameter->endChangeGesture();
     }
 }
 
-void CrossFeedAudioProcessorEditor::buttonStateChanged(Button* )
+void CrossFeedAudioProcessorEditor::comboBoxChanged(ComboBox* comboBox)
 {
-    *processor.bypass = bypassButton.getToggleState();
+    processor.shadowOrder->beginChangeGesture();
+    *processor.shadowOrder = shadowOrderBox.getSelectedItemIndex();
+    processor.shadowOrder->endChangeGesture();
 }
@@ -2,11 +2,14 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "AnalyserDisplay.h"
+#include "ResponseDisplay.h"
 
 //==============================================================================
 /**
 */
-class CrossFeedAudioProcessorEditor : public AudioProcessorEditor, public Slider::Listener, public Button::Listener
+class CrossFeedAudioProcessorEditor : public AudioProcessorEditor, public Slider::Listener, public Button::Listener, public ComboBox::Listener,
+	private AudioProcessorParameter::Listener, private Timer
 {
 public:
 	CrossFeedAudioProcessorEditor(CrossFeedAudioProcessor&);
@@ -30,11 +33,54 @@ private:
 	Slider angleSlider;
 	Label angleLabel;
 
+	Slider yawSlider;
+	Label yawLabel;
+
+	Slider widthSlider;
+	Label widthLabel;
+
+	Slider cutoffSlider;
+	Label cutoffLabel;
+
+	Slider bGainSlider;
+	Label bGainLabel;
+
+	Slider bXGainSlider;
+	Label bXGainLabel;
+
+	Slider bAngleSlider;
+	Label bAngleLabel;
+
+	ComboBox shadowOrderBox;
+
 	ToggleButton bypassButton;
+	ToggleButton trackingButton;
+	ToggleButton autoGainButton;
+	ToggleButton compareButton;
+	ToggleButton selectBButton;
+	TextButton copyAToBButton;
+
+	ResponseDisplay responseDisplay;
+	AnalyserDisplay analyserDisplay;
 
 	void sliderValueChanged(Slider* ) override;
-	void buttonStateChanged(Button* ) override;
-	void buttonClicked(Button* ) override {};
+	void sliderDragStarted(Slider* ) override;
+	void sliderDragEnded(Slider* ) override;
+	void buttonClicked(Button* ) override;
+	void comboBoxChanged(ComboBox* ) override;
+
+	// the parameter each control is attached to
+	AudioParameterFloat* getParameter(Slider* ) const;
+	AudioParameterBool* getParameter(Button* ) const;
+
+	// Parameters change from the host, programs and Copy A to B as well as from the controls, on
+	// any thread: the listener only flags the change, and the timer brings the controls up to date
+	static constexpr int pollRate { 30 };
+	std::atomic<bool> parametersChanged { true };
+	void parameterValueChanged(int, float) override;
+	void parameterGestureChanged(int, bool) override {}
+	void timerCallback() override;
+	void updateControls();
 
 	//==============================================================================
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CrossFeedAudioProcessorEditor)
@@ -8,20 +8,42 @@ CrossFeedAudioProcessor::CrossFeedAudioProcessor ()
 	: AudioProcessor (BusesProperties ()
 #if ! JucePlugin_IsMidiEffect
 #if ! JucePlugin_IsSynth
-		.withInput ("Input", AudioChannelSet::stereo (), true)
+		.withInput ("Input", AudioChannelSet::stereo (), true) // 5.1 and 7.1 are rendered to virtual speakers
 #endif
 		.withOutput ("Output", AudioChannelSet::stereo (), true)
+		.withOutput ("B Output", AudioChannelSet::stereo (), false) // the B setting, while comparing
 #endif
 	)
 #endif
 {
-	addParameter (gaindB = new AudioParameterFloat ("GAIN", "Gain", { minGaindB, maxGaindB, 0.0f, 1.0f }, defaultGaindB, "dB"));
+	// parameters for stages a fixed-configuration build leaves out are still created, so the
+	// pointers below always point somewhere, but are kept from the host rather than added
+	auto addParameterIf = [this](bool isUsed, AudioProcessorParameter* parameter) {
+		if (isUsed)
+			addParameter (parameter);
+		else
+			unusedParameters.add (parameter);
+	};
+	auto initialShadowOrder = ChainConfig::fixedShadowOrder >= 0 ? ChainConfig::fixedShadowOrder : defaultShadowOrder;
+	addParameterIf (ChainConfig::hasOutputGain, gaindB = new AudioParameterFloat ("GAIN", "Gain", { minGaindB, maxGaindB, 0.0f, 1.0f }, defaultGaindB, "dB"));
 	addParameter (xGaindB = new AudioParameterFloat ("XGAIN", "Crossfeed Gain", { minXGaindB, maxXGaindB, 0.0f, 1.0f }, defaultXGaindB, "dB"));
 	addParameter (angle = new AudioParameterFloat ("ANGLE", "Angle", { minAngle, maxAngle, 0.0f, 1.0f }, defaultAngle, "deg"));
+	addParameter (headYaw = new AudioParameterFloat ("YAW", "Head Yaw", { minYaw, maxYaw, 0.0f, 1.0f }, defaultYaw, "deg"));
+	addParameter (headWidth = new AudioParameterFloat ("WIDTH", "Head Width", { minHeadWidth, maxHeadWidth, 0.0f, 1.0f }, defaultHeadWidth, "cm"));
+	addParameter (shadowCutoff = new AudioParameterFloat ("CUTOFF", "Shadow Cutoff", { minShadowCutoff, maxShadowCutoff, 0.0f, 0.5f }, defaultShadowCutoff, "Hz"));
+	addParameterIf (ChainConfig::fixedShadowOrder < 0, shadowOrder = new AudioParameterChoice ("ORDER", "Shadow Order", { "1st order", "2nd order", "2nd order + shelf" }, initialShadowOrder));
+	addParameter (headTracking = new AudioParameterBool ("TRACK", "Head Tracking", false));
 	addParameter (bypass = new AudioParameterBool ("BYPASS", "Bypass", false));
+	addParameterIf (ChainConfig::hasOutputGain, autoGain = new AudioParameterBool ("AUTOGAIN", "Auto Gain", false));
+	addParameter (abCompare = new AudioParameterBool ("AB", "A/B Compare", false));
+	addParameter (abSelect = new AudioParameterBool ("ABSELECT", "A/B Select", false));
+	addParameterIf (ChainConfig::hasOutputGain, bGaindB = new AudioParameterFloat ("BGAIN", "B Gain", { minGaindB, maxGaindB, 0.0f, 1.0f }, defaultGaindB, "dB"));
+	addParameter (bXGaindB = new AudioParameterFloat ("BXGAIN", "B Crossfeed Gain", { minXGaindB, maxXGaindB, 0.0f, 1.0f }, defaultXGaindB, "dB"));
+	addParameter (bAngle = new AudioParameterFloat ("BANGLE", "B Angle", { minAngle, maxAngle, 0.0f, 1.0f }, defaultAngle, "deg"));
+	loudnessMatcher = std::make_unique<LoudnessMatcher> (*this, *autoGain);
 	//fastNormalise.initialise ([](float x) { return 1.0f / std::sqrt (1.0f + x * x); }, 0.0f, 1.0f, 10000);
 	dBToMagnitude.initialise ([](float x) { return std::pow (10.0f, x * 0.05f); }, -15.0f, 15.0f, 10000);
-	sinXByTwo.initialise ([](float x) { return std::sin (pi * 0.005555555f * x * 0.5f); }, 30.0f, 90.0f, 10000); // 1/180 = 0.00555...
+	sinXByTwo.initialise ([](float x) { return std::sin (pi * 0.005555555f * x * 0.5f); }, 0.0f, 360.0f, 10000); // 1/180 = 0.00555...
 }
 
 CrossFeedAudioProcessor::~CrossFeedAudioProcessor () {}
@@ -29,16 +51,42 @@ CrossFeedAudioProcessor::~CrossFeedAudioProcessor () {}
 //==============================================================================
 // Utility functions for DAW
 const String CrossFeedAudioProcessor::getName () const { return JucePlugin_Name; }
-bool CrossFeedAudioProcessor::acceptsMidi () const { return false; }
+bool CrossFeedAudioProcessor::acceptsMidi () const { return true; }
 bool CrossFeedAudioProcessor::producesMidi () const { return false; }
 bool CrossFeedAudioProcessor::isMidiEffect () const { return false; }
 double CrossFeedAudioProcessor::getTailLengthSeconds () const { return 0.0; }
-int CrossFeedAudioProcessor::getNumPrograms () { return 1; }
-int CrossFeedAudioProcessor::getCurrentProgram () { return 0; }
-void CrossFeedAudioProcessor::setCurrentProgram (int index) {}
-const String CrossFeedAudioProcessor::getProgramName (int index) { return {}; }
+int CrossFeedAudioProcessor::getNumPrograms () { return numPrograms; }
+int CrossFeedAudioProcessor::getCurrentProgram () { return currentProgram; }
+const String CrossFeedAudioProcessor::getProgramName (int index) { return isPositiveAndBelow (index, numPrograms) ? programs[index].name : ""; }
 void CrossFeedAudioProcessor::changeProgramName (int index, const String& newName) {}
 
+const CrossFeedAudioProcessor::Program CrossFeedAudioProcessor::programs[] = {
+	{ "Default", defaultGaindB, defaultXGaindB, defaultAngle },
+	{ "Near-field 30 deg", 0.0f, -6.0f, 30.0f },
+	{ "Wide 60 deg", 0.0f, -3.0f, 60.0f },
+	{ "Mono-ish", -3.0f, 0.0f, 90.0f },
+};
+
+void CrossFeedAudioProcessor::setCurrentProgram (int index)
+{
+	if (! isPositiveAndBelow (index, numPrograms))
+		return;
+
+	// update the parameters first so the audio thread never reverts the program it has just applied
+	currentProgram = index;
+	*gaindB = programs[index].gaindB;
+	*xGaindB = programs[index].xGaindB;
+	*angle = programs[index].angle;
+	pendingProgram = &programStates[size_t (index)];
+}
+
+void CrossFeedAudioProcessor::copyAToB ()
+{
+	*bGaindB = gaindB->get ();
+	*bXGaindB = xGaindB->get ();
+	*bAngle = angle->get ();
+}
+
 #ifndef JucePlugin_PreferredChannelConfigurations
 bool CrossFeedAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
@@ -47,15 +95,20 @@ bool CrossFeedAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts
 		|| layouts.getMainOutputChannelSet () == AudioChannelSet::disabled ())
 		return false;
 
-	// only support stereo
+	// output is always stereo for headphones
 	if (layouts.getMainOutputChannelSet () != AudioChannelSet::stereo ())
 		return false;
 
-	// check if input and output are both stereo
-	if (layouts.getMainOutputChannelSet () != layouts.getMainInputChannelSet ())
+	// input is either stereo or a surround layout rendered through virtual speakers; the B output
+	// is stereo, and only for stereo input, which is all the comparison renders
+	auto input = layouts.getMainInputChannelSet ();
+	auto comparisonOutput = layouts.getNumChannels (false, 1);
+	if (input == AudioChannelSet::stereo ())
+		return comparisonOutput == 0 || comparisonOutput == 2;
+	if (comparisonOutput != 0)
 		return false;
-
-	return true;
+	return ChainConfig::canBeSurround
+		&& (input == AudioChannelSet::create5point1 () || input == AudioChannelSet::create7point1 ());
 }
 #endif
 
@@ -64,14 +117,14 @@ AudioProcessorParameter* CrossFeedAudioProcessor::getBypassParameter () const {
 //==============================================================================
 // Main processing
 
-void CrossFeedAudioProcessor::stereoToMidSide (AudioBuffer<float> buffer)
+void CrossFeedAudioProcessor::stereoToMidSide (dsp::AudioBlock<float> block)
 {
-	jassert (buffer.getNumChannels () == 2);
-	float* l = buffer.getWritePointer (0);
-	float* r = buffer.getWritePointer (1);
-	auto n = buffer.getNumSamples ();
+	jassert (block.getNumChannels () == 2);
+	float* l = block.getChannelPointer (0);
+	float* r = block.getChannelPointer (1);
+	auto n = block.getNumSamples ();
 	float temp;
-	for (auto i = 0; i < n; ++i) {
+	for (size_t i = 0; i < n; ++i) {
 		temp = (*l + *r) * inverseSqrtTwo;
 		*r = (*l - *r) * inverseSqrtTwo;
 		*l = temp;
@@ -79,116 +132,1275 @@ void CrossFeedAudioProcessor::stereoToMidSide (AudioBuffer<float> buffer)
 	}
 }
 
+void CrossFeedAudioProcessor::stereoToMidSide (float* frames, size_t numFrames) noexcept
+{
+	for (size_t i = 0; i < 2 * numFrames; i += 2) {
+		auto l = frames[i], r = frames[i + 1];
+		frames[i] = (l + r) * inverseSqrtTwo;
+		frames[i + 1] = (l - r) * inverseSqrtTwo;
+	}
+}
+
+void CrossFeedAudioProcessor::foldDown (const dsp::AudioBlock<float>& source, float* left, float* right) const noexcept
+{
+	auto n = int (source.getNumSamples ());
+	for (auto c : { centreChannel, lfeChannel }) {
+		if (c >= 0) {
+			FloatVectorOperations::addWithMultiply (left, source.getChannelPointer (size_t (c)), inverseSqrtTwo, n);
+			FloatVectorOperations::addWithMultiply (right, source.getChannelPointer (size_t (c)), inverseSqrtTwo, n);
+		}
+	}
+	for (size_t p = 1; p < numSpeakerPairs; ++p) {
+		FloatVectorOperations::add (left, source.getChannelPointer (size_t (speakerPairs[p].leftChannel)), n);
+		FloatVectorOperations::add (right, source.getChannelPointer (size_t (speakerPairs[p].rightChannel)), n);
+	}
+}
+
+void CrossFeedAudioProcessor::setUpSpeakerPairs ()
+{
+	// JUCE orders the front pair first in every supported layout
+	auto input = getChannelLayoutOfBus (true, 0);
+	jassert (input.getChannelIndexForType (AudioChannelSet::left) == 0);
+	jassert (input.getChannelIndexForType (AudioChannelSet::right) == 1);
+	numSpeakerPairs = 1;
+	centreChannel = input.getChannelIndexForType (AudioChannelSet::centre);
+	lfeChannel = input.getChannelIndexForType (AudioChannelSet::LFE);
+
+	auto addPair = [this, &input](AudioChannelSet::ChannelType left, AudioChannelSet::ChannelType right, float azimuth) {
+		auto l = input.getChannelIndexForType (left);
+		auto r = input.getChannelIndexForType (right);
+		if (l < 0 || r < 0 || numSpeakerPairs == maxSpeakerPairs)
+			return;
+		auto& pair = speakerPairs[numSpeakerPairs++];
+		pair.leftChannel = l;
+		pair.rightChannel = r;
+		pair.azimuth = azimuth;
+	};
+
+	// ITU-R BS.775 placement; 5.1 surrounds sit at 110 degrees, 7.1 splits them into sides and rears
+	addPair (AudioChannelSet::leftSurround, AudioChannelSet::rightSurround, 110.0f);
+	addPair (AudioChannelSet::leftSurroundSide, AudioChannelSet::rightSurroundSide, 90.0f);
+	addPair (AudioChannelSet::leftSurroundRear, AudioChannelSet::rightSurroundRear, 150.0f);
+}
+
+void CrossFeedAudioProcessor::layOutState (StateArena& target)
+{
+	target.beginLayout ();
+
+	// coefficients and filter state are touched on every segment, so they share the leading cache lines
+	lpFilt.allocate (target);
+	shadowFilt.allocate (target);
+	midShelfFilt.allocate (target);
+	sideShelfFilt.allocate (target);
+	comparison.lpFilt.allocate (target);
+	comparison.shadowFilt.allocate (target);
+	comparison.midShelfFilt.allocate (target);
+	comparison.sideShelfFilt.allocate (target);
+
+	// scratch space for the crossfeed
+	for (auto& c : auxChannels)
+		c = target.allocate<float> (maxSegmentSize, StateArena::cacheLineSize);
+	for (auto& c : pairChannels)
+		c = target.allocate<float> (maxSegmentSize, StateArena::cacheLineSize);
+	interleavedAux = target.allocate<float> (2 * maxSegmentSize, StateArena::cacheLineSize);
+	for (auto& c : planarChannels)
+		c = target.allocate<float> (maxSegmentSize, StateArena::cacheLineSize);
+	for (auto& c : dryChannels)
+		c = target.allocate<float> (maxSegmentSize, StateArena::cacheLineSize);
+	for (auto& c : comparisonChannels)
+		c = target.allocate<float> (maxSegmentSize, StateArena::cacheLineSize);
+	for (auto& c : tailChannels)
+		c = target.allocate<float> (warmUpLength, StateArena::cacheLineSize);
+}
+
+void CrossFeedAudioProcessor::resetState ()
+{
+	lpFilt.reset ();
+	shadowFilt.reset ();
+	lpDelayComp.reset ();
+	dryDelay.reset ();
+	for (size_t p = 0; p < numSpeakerPairs; ++p)
+		for (auto& d : speakerPairs[p].ITDFilt)
+			d.reset ();
+	midShelfFilt.reset ();
+	sideShelfFilt.reset ();
+	resetComparison ();
+	lastCrossfeed = {};
+}
+
+void CrossFeedAudioProcessor::resetComparison ()
+{
+	// B starts silent and from its targets, rather than from whatever it last played
+	for (auto& d : comparison.ITDFilt)
+		d.reset ();
+	for (auto& g : comparison.xGainSmoothed)
+		g.setCurrentAndTargetValue (g.getTargetValue ());
+	comparison.gain.setCurrentAndTargetValue (comparison.gain.getTargetValue ());
+	comparison.lpDelayComp.reset ();
+	comparison.lpFilt.reset ();
+	comparison.shadowFilt.reset ();
+	comparison.lastCrossfeed = {};
+	comparison.midShelfFilt.reset ();
+	comparison.sideShelfFilt.reset ();
+}
+
 void CrossFeedAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
 	float Fs = float (sampleRate);
 
-	// set up correct sampling rate, block size, and channel specifications for the filters
-	auto channels = jmin (getMainBusNumInputChannels (), getMainBusNumOutputChannels ());
-	dsp::ProcessSpec spec { sampleRate, static_cast<uint32>(samplesPerBlock), channels };
-
-	// compute single-pole lowpass filter coefficients
+	// set up correct sampling rate, block size, and channel specifications for the filters;
+	// everything after the speaker matrix runs on the stereo headphone signal
+	dsp::ProcessSpec spec { sampleRate, static_cast<uint32>(samplesPerBlock), 2 };
+	dsp::ProcessSpec monoSpec { sampleRate, static_cast<uint32>(samplesPerBlock), 1 };
+	setUpSpeakerPairs ();
 	lpFilt.prepare (spec);
-	float y = 1 - dsp::FastMathApproximations::cos (2.0f * pi * (wc / Fs));
-	float a = -y + std::sqrt (y * y + y * 2.0f);
-	*lpFilt.state = dsp::IIR::Coefficients<float> (a, 0, 1.0f, a - 1.0f);
+	midShelfFilt.prepare (monoSpec);
+	sideShelfFilt.prepare (monoSpec);
+	comparison.lpFilt.prepare (spec);
+	comparison.midShelfFilt.prepare (monoSpec);
+	comparison.sideShelfFilt.prepare (monoSpec);
+	hasComparisonBus = getChannelCountOfBus (false, 1) == 2;
+
+	// the lowest cutoff of the slowest model has the longest group delay, which sets the delay compensation
+	lpDelay = 0;
+	CoefficientSet slowest;
+	for (int order = 0; order < numShadowOrders; ++order) {
+		if (ChainConfig::fixedShadowOrder >= 0 && order != ChainConfig::fixedShadowOrder)
+			continue;
+		computeShadow (minShadowCutoff, order, Fs, slowest);
+		lpDelay = jmax (lpDelay, size_t (jmax (0.0f, slowest.shadowGroupDelay)));
+	}
+	// beyond the highest supported rate the compensation falls short rather than overrunning
+	jassert (sampleRate <= maxSampleRate);
+	lpDelay = jmin (lpDelay, compensationCapacity - 1);
+	cutoffSmoothed.reset (sampleRate, cutoffRampTime);
+	cutoffSmoothed.setCurrentAndTargetValue (*shadowCutoff);
+	shelfXGaindB.reset (sampleRate, xGainRampTime);
+	shelfXGaindB.setCurrentAndTargetValue (*xGaindB);
 
 	// delay compensation for the lowpass filter
 	lpDelayComp.prepare (spec);
-	minDelay = size_t (std::floor (sinXByTwo (minAngle) * headTime * Fs));
-	lpDelay = size_t (std::floor (1.0f / a - 1.0f));
+	minDelay = size_t (std::floor (sinXByTwo (minAngle) * minHeadWidth * 0.01f / speedOfSound * Fs));
 	lpDelayComp.setMaxDelayInSamples (lpDelay);
-	lpDelayComp.setDelayInSamples (lpDelay);
+	comparison.lpDelayComp.prepare (spec);
+	comparison.lpDelayComp.setMaxDelayInSamples (lpDelay);
 	setLatencySamples (lpDelay);
 
-	// delay filter 
-	ITDFilt.prepare (spec);
-	ITDFilt.setMaxDelayInSamples (size_t (std::floor (headTime* Fs)));
+	// latency-aligned dry path for bypass
+	dryDelay.prepare (spec);
+	dryDelay.setMaxDelayInSamples (lpDelay);
+	wetMix.reset (sampleRate, bypassFadeTime);
+	wetMix.setCurrentAndTargetValue (*bypass ? 0.0f : 1.0f);
+	size_t maxITD = size_t (std::floor (maxHeadWidth * 0.01f / speedOfSound * Fs)) + lpDelay;
+	// the group delay at DC is about one time constant of the head-shadow filter
+	warmUpLength = size_t (std::ceil (warmUpTimeConstants * float (lpDelay + 1))) + maxITD;
+
+	// delay filter and crossfeed gain, one per ear for each speaker pair
+	for (auto& pair : speakerPairs) {
+		for (auto& d : pair.ITDFilt) {
+			d.prepare (monoSpec);
+			d.setMaxDelayInSamples (maxITD);
+			d.setCrossfadeLengthInSamples (size_t (std::ceil (itdCrossfadeTime * Fs)));
+		}
+		for (auto& g : pair.xGainSmoothed)
+			g.reset (sampleRate, xGainRampTime);
+	}
+	for (auto& d : comparison.ITDFilt) {
+		d.prepare (monoSpec);
+		d.setMaxDelayInSamples (maxITD);
+		d.setCrossfadeLengthInSamples (size_t (std::ceil (itdCrossfadeTime * Fs)));
+	}
+	for (auto& g : comparison.xGainSmoothed)
+		g.reset (sampleRate, xGainRampTime);
+	comparison.gain.reset (sampleRate, gainRampTime);
+	selectB.reset (sampleRate, abFadeTime);
+	selectB.setCurrentAndTargetValue (*abSelect ? 1.0f : 0.0f);
+
+	// the meter and loudness taps hold only what their readers take per interval
+	meterFifo.prepare (sampleRate, samplesPerBlock);
+	loudnessMatcher->prepare (sampleRate, samplesPerBlock);
+
+	// offline hosts may hand over long blocks, which are split across the cores
+	if (isNonRealtime () && samplesPerBlock >= offlineBlockThreshold) {
+		if (offlineWorkers == nullptr)
+			offlineWorkers = std::make_unique<SharedResourcePointer<OfflineWorkers>> ();
+		offlineChannels.setSize (4, samplesPerBlock);
+	}
+	else {
+		offlineChannels.setSize (0, 0);
+	}
+
+	// measure the state, then lay it out in the arena
+	StateArena measure;
+	layOutState (measure);
+	arena.allocateStorage (measure.getBytesUsed ());
+	layOutState (arena);
+	resetState ();
+
+	lpDelayComp.setDelayInSamples (lpDelay);
+	lpDelayComp.reset ();
+	comparison.lpDelayComp.setDelayInSamples (lpDelay);
+	dryDelay.setDelayInSamples (lpDelay);
+	dryDelay.reset ();
 
 	// Mid and side shelf set-up
-	midShelfFilt.prepare (spec);
-	sideShelfFilt.prepare (spec);
-	*midShelfFilt.coefficients = dsp::IIR::Coefficients<float>::Coefficients (1, 0, 1, 0);
-	*sideShelfFilt.coefficients = dsp::IIR::Coefficients<float>::Coefficients (1, 0, 1, 0);
+	midShelfFilt.getCoefficients ().set (1, 0, 1, 0);
+	sideShelfFilt.getCoefficients ().set (1, 0, 1, 0);
+
+	// precompute every program for this sample rate, so switching needs no maths on the audio thread
+	for (int i = 0; i < numPrograms; ++i) {
+		auto& state = programStates[size_t (i)];
+		state.gaindB = programs[i].gaindB;
+		state.xGaindB = programs[i].xGaindB;
+		state.angle = programs[i].angle;
+		state.headWidth = defaultHeadWidth;
+		state.cutoff = defaultShadowCutoff;
+		state.shadowOrder = ChainConfig::fixedShadowOrder >= 0 ? ChainConfig::fixedShadowOrder : defaultShadowOrder;
+		computeGain (state.gaindB, state.coefficients);
+		computeShadow (state.cutoff, state.shadowOrder, Fs, state.coefficients);
+		computeCrossfeed (state.angle, 0.0f, state.xGaindB, state.headWidth, Fs, state.coefficients);
+		computeShelves (state.xGaindB, state.coefficients);
+	}
+	pendingProgram = nullptr;
+
+	// force a full parameter update on the first segment
+	gain.reset (sampleRate, gainRampTime);
+	lastGaindB = lastXGaindB = lastAngle = lastYaw = std::numeric_limits<float>::quiet_NaN ();
+	lastHeadWidth = lastCutoff = lastShelfXGaindB = std::numeric_limits<float>::quiet_NaN ();
+	lastShadowOrder = -1;
+
+	// start from the current parameters rather than crossfading in from a zero ITD
+	updateParameters (Fs, 0);
+	for (size_t p = 0; p < numSpeakerPairs; ++p) {
+		auto& pair = speakerPairs[p];
+		for (auto& d : pair.ITDFilt)
+			d.reset ();
+		for (auto& g : pair.xGainSmoothed)
+			g.setCurrentAndTargetValue (g.getTargetValue ());
+	}
+	gain.setCurrentAndTargetValue (gain.getTargetValue ());
+	comparisonIsStale = true;
+	updateComparison (Fs);
+	resetComparison ();
+	wasComparing = isComparing ();
+}
+
+void CrossFeedAudioProcessor::computeGain (float newGaindB, CoefficientSet& target) const noexcept
+{
+	target.gain = ChainConfig::hasOutputGain ? dBToMagnitude (newGaindB) : 1.0f;
+}
+
+int CrossFeedAudioProcessor::getShadowOrder () const noexcept
+{
+	return ChainConfig::fixedShadowOrder >= 0 ? ChainConfig::fixedShadowOrder : shadowOrder->getIndex ();
+}
+
+void CrossFeedAudioProcessor::computeShadow (float newCutoff, int newOrder, float sampleRate, CoefficientSet& target) const noexcept
+{
+	// the single-pole lowpass is always computed, as the shelves share its pole; with
+	// y = 1 - cos (w0) = 2 sin^2 (w0 / 2), a = sqrt (y^2 + 2y) - y, good for any cutoff below Nyquist
+	float sinHalfW0 = sinXByTwo (360.0f * newCutoff / sampleRate);
+	float y = 2.0f * sinHalfW0 * sinHalfW0;
+	float a = std::sqrt (y * y + y * 2.0f) - y;
+	target.lowpass.set (a, 0.0f, 1.0f, a - 1.0f);
+	target.numShadowSections = size_t (newOrder);
+	float groupDelay = 1.0f / a - 1.0f;
+
+	// cookbook biquads, with sin and cos of w0 from the half-angle table: sinXByTwo (x) = sin (x * pi / 360)
+	if (newOrder > 0) {
+		float x = 360.0f * newCutoff / sampleRate;
+		float sinW = sinXByTwo (2.0f * x);
+		float sinHalfW = sinXByTwo (x);
+		float cosW = 1.0f - 2.0f * sinHalfW * sinHalfW;
+		// Butterworth lowpass, alpha = sin (w0) / 2Q with Q = 1/sqrt2
+		float alpha = sinW * inverseSqrtTwo;
+		target.shadowSections[0].set ((1.0f - cosW) * 0.5f, 1.0f - cosW, (1.0f - cosW) * 0.5f,
+			1.0f + alpha, -2.0f * cosW, 1.0f - alpha);
+		groupDelay = target.shadowSections[0].getDCGroupDelay ();
+	}
+	if (newOrder > 1) {
+		float x = 360.0f * shadowShelfFrequency / sampleRate;
+		float sinW = sinXByTwo (2.0f * x);
+		float sinHalfW = sinXByTwo (x);
+		float cosW = 1.0f - 2.0f * sinHalfW * sinHalfW;
+		// high shelf with slope 1, A = 10^(dB/40)
+		float A = dBToMagnitude (shadowShelfdB * 0.5f);
+		float twoSqrtAAlpha = 2.0f * dBToMagnitude (shadowShelfdB * 0.25f) * sinW * inverseSqrtTwo;
+		target.shadowSections[1].set (A * ((A + 1.0f) + (A - 1.0f) * cosW + twoSqrtAAlpha),
+			-2.0f * A * ((A - 1.0f) + (A + 1.0f) * cosW),
+			A * ((A + 1.0f) + (A - 1.0f) * cosW - twoSqrtAAlpha),
+			(A + 1.0f) - (A - 1.0f) * cosW + twoSqrtAAlpha,
+			2.0f * ((A - 1.0f) - (A + 1.0f) * cosW),
+			(A + 1.0f) - (A - 1.0f) * cosW - twoSqrtAAlpha);
+		groupDelay += target.shadowSections[1].getDCGroupDelay ();
+	}
+
+	// the direct path is compensated for the slowest model, so the crossfeed waits out the difference
+	target.shadowGroupDelay = groupDelay;
+	target.shadowDelay = lpDelay - jmin (lpDelay, size_t (jmax (0.0f, groupDelay)));
+}
+
+void CrossFeedAudioProcessor::computeCrossfeed (float newAngle, float newYaw, float newXGaindB, float newHeadWidth, float sampleRate, CoefficientSet& target) const noexcept
+{
+	float headTime = newHeadWidth * 0.01f / speedOfSound;
+	float centred = sinXByTwo (newAngle);
+	for (size_t p = 0; p < numSpeakerPairs; ++p) {
+		auto& pair = speakerPairs[p];
+		auto azimuth = pair.azimuth > 0.0f ? pair.azimuth : newAngle * 0.5f;
+		// turning the head right moves the right speaker towards the nose and the left one away
+		float incidence[2] = { azimuth - newYaw, azimuth + newYaw };
+		for (size_t ear = 0; ear < 2; ++ear) {
+			float s = sinXByTwo (2.0f * jlimit (0.0f, 180.0f, incidence[ear]));
+			target.ITDs[p][ear] = size_t (std::floor (s * headTime * sampleRate)) + target.shadowDelay;
+			// a more lateral speaker is shadowed more strongly by the head
+			target.xGains[p][ear] = dBToMagnitude (newXGaindB + yawShadowdB * (s - centred));
+		}
+	}
+}
+
+void CrossFeedAudioProcessor::computeShelves (float newXGaindB, CoefficientSet& target) const noexcept
+{
+	float g = dBToMagnitude (newXGaindB - 2);
+	// the shelves share the pole of the head-shadow lowpass
+	float a = target.lowpass.b0;
+	target.midShelf.set (1.0f, (a - 1.0f), 1.0f + g * a, a - 1.0f);
+	g = dBToMagnitude (newXGaindB - 6);
+	target.sideShelf.set (1.0f, (a - 1.0f), 1.0f - g * a, a - 1.0f);
+}
+
+void CrossFeedAudioProcessor::applyCoefficients (const CoefficientSet& source) noexcept
+{
+	// delays crossfade and gains ramp to their new values; unchanged ones cost nothing
+	gain.setTargetValue (source.gain * makeupGain);
+	for (size_t p = 0; p < numSpeakerPairs; ++p) {
+		for (size_t ear = 0; ear < 2; ++ear) {
+			speakerPairs[p].ITDFilt[ear].setDelayInSamples (source.ITDs[p][ear]);
+			speakerPairs[p].xGainSmoothed[ear].setTargetValue (source.xGains[p][ear]);
+		}
+	}
+	lpFilt.getCoefficients () = source.lowpass;
+	for (size_t k = 0; k < source.numShadowSections; ++k)
+		shadowFilt.getCoefficients (k) = source.shadowSections[k];
+	// the state of a different model means nothing to this one, so start from where the old one left off
+	if (source.numShadowSections != shadowFilt.getNumSections ()) {
+		shadowFilt.setNumSections (source.numShadowSections);
+		for (size_t chan = 0; chan < 2; ++chan) {
+			shadowFilt.prime (chan, lastCrossfeed[chan]);
+			lpFilt.prime (chan, lastCrossfeed[chan]);
+		}
+	}
+	midShelfFilt.getCoefficients () = source.midShelf;
+	sideShelfFilt.getCoefficients () = source.sideShelf;
+}
+
+FixedPointSettings CrossFeedAudioProcessor::getFixedPointSettings () const noexcept
+{
+	jassert (coefficients.numShadowSections == 0);
+	FixedPointSettings settings;
+	settings.lpDelay = lpDelay;
+	for (size_t ear = 0; ear < 2; ++ear) {
+		settings.ITDs[ear] = coefficients.ITDs[0][ear];
+		settings.xGains[ear] = coefficients.xGains[0][ear];
+	}
+	settings.gain = coefficients.gain;
+	settings.lowpass = coefficients.lowpass;
+	settings.midShelf = coefficients.midShelf;
+	settings.sideShelf = coefficients.sideShelf;
+	return settings;
+}
+
+size_t CrossFeedAudioProcessor::getNumClampedDelays () const noexcept
+{
+	auto count = lpDelayComp.getNumClampedRequests () + dryDelay.getNumClampedRequests ();
+	for (auto& pair : speakerPairs)
+		for (auto& d : pair.ITDFilt)
+			count += d.getNumClampedRequests ();
+	for (auto& d : comparison.ITDFilt)
+		count += d.getNumClampedRequests ();
+	return count;
+}
+
+void CrossFeedAudioProcessor::computeResponse (const ResponseGrid& grid, ResponseCurves& curves) const
+{
+	// the coefficients the audio thread settles on for these parameters; MIDI yaw belongs to the
+	// audio thread, so head tracking shows the yaw parameter
+	CoefficientSet target;
+	float newXGaindB = *xGaindB;
+	computeGain (*gaindB, target);
+	computeShadow (*shadowCutoff, getShadowOrder (), grid.sampleRate, target);
+	computeCrossfeed (*angle, *headTracking ? headYaw->get () : 0.0f, newXGaindB, *headWidth, grid.sampleRate, target);
+	computeShelves (newXGaindB, target);
+
+	// crossfeed into each ear: ITD, gain and head shadow, less the direct path's delay
+	ComplexResponse shadow;
+	shadow.setToConstant (grid, 1.0f);
+	if (target.numShadowSections == 0)
+		shadow.applyFilter (grid, target.lowpass);
+	for (size_t k = 0; k < target.numShadowSections; ++k)
+		shadow.applyFilter (grid, target.shadowSections[k]);
+	std::array<ComplexResponse, 2> crossfeed;
+	for (size_t ear = 0; ear < 2; ++ear) {
+		crossfeed[ear] = shadow;
+		crossfeed[ear].multiplyBy (target.xGains[0][ear]);
+		crossfeed[ear].applyDelay (grid, float (target.ITDs[0][ear]) - float (lpDelay));
+	}
+
+	ComplexResponse mid, side;
+	mid.setToConstant (grid, 1.0f);
+	side.setToConstant (grid, 1.0f);
+	if (ChainConfig::hasShelves) {
+		mid.applyFilter (grid, target.midShelf);
+		side.applyFilter (grid, target.sideShelf);
+	}
+
+	// left out = g/2 (Hm (L + R + C0 R + C1 L) + Hs (L - R + C0 R - C1 L)), where Ce is the
+	// crossfeed into ear e; the left input reaches it as g/2 (Hm (1 + C1) + Hs (1 - C1))
+	auto toLeftEar = [&](const ComplexResponse& farCrossfeed, float directSign, ComplexResponse& result) {
+		auto viaSide = farCrossfeed;
+		viaSide.multiplyBy (-directSign);
+		viaSide.addConstant (directSign);
+		viaSide.multiplyBy (side);
+		result = farCrossfeed;
+		result.addConstant (1.0f);
+		result.multiplyBy (mid);
+		result.addWithMultiply (viaSide, 1.0f);
+		result.multiplyBy (0.5f * target.gain);
+	};
+	toLeftEar (crossfeed[1], 1.0f, curves.direct);
+	// and the right input as g/2 (Hm (1 + C0) + Hs (C0 - 1))
+	toLeftEar (crossfeed[0], -1.0f, curves.crossfeed);
+	curves.centre = curves.direct;
+	curves.centre.addWithMultiply (curves.crossfeed, 1.0f);
+}
+
+void CrossFeedAudioProcessor::applyProgram (const ProgramState& program) noexcept
+{
+	// programs are precomputed facing forwards with the default head; otherwise leave the maths
+	// to the next parameter update
+	if (lastYaw != 0.0f || lastHeadWidth != program.headWidth || lastCutoff != program.cutoff
+		|| lastShadowOrder != program.shadowOrder) {
+		lastGaindB = lastXGaindB = lastAngle = std::numeric_limits<float>::quiet_NaN ();
+		return;
+	}
+
+	// the shelves glide to the program's crossfeed gain over the next segments instead
+	auto midShelf = coefficients.midShelf;
+	auto sideShelf = coefficients.sideShelf;
+	coefficients = program.coefficients;
+	coefficients.midShelf = midShelf;
+	coefficients.sideShelf = sideShelf;
+	applyCoefficients (coefficients);
+	comparisonIsStale = true;
+	lastGaindB = program.gaindB;
+	lastXGaindB = program.xGaindB;
+	lastAngle = program.angle;
 }
 
-void inline CrossFeedAudioProcessor::updateParameters (float sampleRate)
+void inline CrossFeedAudioProcessor::updateParameters (float sampleRate, int numSamples)
 {
-	//update gain parameters
-	gain = dBToMagnitude (*gaindB);
-	xGain = dBToMagnitude (*xGaindB);
+	// this runs once per segment, so only do work for the parameters that actually moved
+	float newGaindB = *gaindB;
+	float newXGaindB = *xGaindB;
+	float newAngle = *angle;
+	float newYaw = *headTracking ? (hasMidiYaw ? midiYaw : headYaw->get ()) : 0.0f;
+	float newHeadWidth = *headWidth;
+	cutoffSmoothed.setTargetValue (*shadowCutoff);
+	float newCutoff = cutoffSmoothed.skip (numSamples);
+	shelfXGaindB.setTargetValue (newXGaindB);
+	float newShelfXGaindB = shelfXGaindB.skip (numSamples);
+	int newShadowOrder = getShadowOrder ();
+
+	float newMakeupGain = loudnessMatcher->getMakeupGain ();
+	bool gainChanged = newGaindB != lastGaindB || newMakeupGain != makeupGain;
+	bool shadowChanged = newCutoff != lastCutoff || newShadowOrder != lastShadowOrder;
+	bool crossfeedChanged = shadowChanged || newAngle != lastAngle || newYaw != lastYaw
+		|| newXGaindB != lastXGaindB || newHeadWidth != lastHeadWidth;
+	bool shelvesChanged = shadowChanged || newShelfXGaindB != lastShelfXGaindB;
+	if (! (gainChanged || crossfeedChanged || shelvesChanged))
+		return;
+
+	//update gain parameters, the makeup riding on the ramp of the output gain
+	if (gainChanged) {
+		computeGain (newGaindB, coefficients);
+		makeupGain = newMakeupGain;
+	}
+
+	// update the head-shadow lowpass and the crossfeed delay that keeps it aligned
+	if (shadowChanged)
+		computeShadow (newCutoff, newShadowOrder, sampleRate, coefficients);
 
-	// update delay amount and delay filter
-	nsamps = size_t (std::floor (sinXByTwo (*angle) * headTime * sampleRate)); // 1/180 = 0.00555...
-	ITDFilt.setDelayInSamples (nsamps);
+	// update per-ear delay amounts and crossfeed gains
+	if (crossfeedChanged)
+		computeCrossfeed (newAngle, newYaw, newXGaindB, newHeadWidth, sampleRate, coefficients);
 
 	// update shelving filter coefficients
-	float g = dBToMagnitude (*xGaindB-2);
-	float a = lpFilt.state->getRawCoefficients ()[0];
-	*midShelfFilt.coefficients = dsp::IIR::Coefficients<float>::Coefficients (1.0f, (a - 1.0f), 1.0f + g * a, a - 1.0f);
-	g = dBToMagnitude (*xGaindB-6);
-	*sideShelfFilt.coefficients = dsp::IIR::Coefficients<float>::Coefficients (1.0f, (a - 1.0f), 1.0f - g * a, a - 1.0f);
+	if (shelvesChanged) {
+		xGain = dBToMagnitude (newShelfXGaindB);
+		computeShelves (newShelfXGaindB, coefficients);
+	}
+
+	applyCoefficients (coefficients);
+	comparisonIsStale = true;
+	lastGaindB = newGaindB;
+	lastXGaindB = newXGaindB;
+	lastAngle = newAngle;
+	lastYaw = newYaw;
+	lastHeadWidth = newHeadWidth;
+	lastCutoff = newCutoff;
+	lastShelfXGaindB = newShelfXGaindB;
+	lastShadowOrder = newShadowOrder;
+}
+
+bool CrossFeedAudioProcessor::isComparing () const noexcept
+{
+	return *abCompare && getTotalNumInputChannels () == 2;
+}
+
+void CrossFeedAudioProcessor::updateComparison (float sampleRate)
+{
+	float newGaindB = *bGaindB;
+	float newXGaindB = *bXGaindB;
+	float newAngle = *bAngle;
+	if (! comparisonIsStale && newGaindB == comparison.lastGaindB && newXGaindB == comparison.lastXGaindB
+		&& newAngle == comparison.lastAngle)
+		return;
+
+	// B shares the head shadow, head width and yaw with A, so it starts from A's coefficients
+	auto& target = comparison.coefficients;
+	target = coefficients;
+	computeGain (newGaindB, target);
+	computeCrossfeed (newAngle, lastYaw, newXGaindB, lastHeadWidth, sampleRate, target);
+	computeShelves (newXGaindB, target);
+
+	comparison.gain.setTargetValue (target.gain * makeupGain);
+	for (size_t ear = 0; ear < 2; ++ear) {
+		comparison.ITDFilt[ear].setDelayInSamples (target.ITDs[0][ear]);
+		comparison.xGainSmoothed[ear].setTargetValue (target.xGains[0][ear]);
+	}
+	comparison.lpFilt.getCoefficients () = target.lowpass;
+	for (size_t k = 0; k < target.numShadowSections; ++k)
+		comparison.shadowFilt.getCoefficients (k) = target.shadowSections[k];
+	if (target.numShadowSections != comparison.shadowFilt.getNumSections ()) {
+		comparison.shadowFilt.setNumSections (target.numShadowSections);
+		for (size_t chan = 0; chan < 2; ++chan) {
+			comparison.shadowFilt.prime (chan, comparison.lastCrossfeed[chan]);
+			comparison.lpFilt.prime (chan, comparison.lastCrossfeed[chan]);
+		}
+	}
+	comparison.midShelfFilt.getCoefficients () = target.midShelf;
+	comparison.sideShelfFilt.getCoefficients () = target.sideShelf;
+	comparison.lastGaindB = newGaindB;
+	comparison.lastXGaindB = newXGaindB;
+	comparison.lastAngle = newAngle;
+	comparisonIsStale = false;
 }
 
 void CrossFeedAudioProcessor::releaseResources ()
 {
-	lpFilt.reset ();
-	lpDelayComp.reset ();
-	ITDFilt.reset ();
-	midShelfFilt.reset ();
-	sideShelfFilt.reset ();
+	resetState ();
 }
 
-void CrossFeedAudioProcessor::processBlock (AudioBuffer<float>& ioBuffer, MidiBuffer&)
+void CrossFeedAudioProcessor::setNonRealtime (bool isNonRealtime) noexcept
+{
+	AudioProcessor::setNonRealtime (isNonRealtime);
+	loudnessMatcher->setOffline (isNonRealtime);
+}
+
+void CrossFeedAudioProcessor::handleMidiEvent (const MidiMessage& message) noexcept
+{
+	if (! message.isController ())
+		return;
+
+	// the MSB alone gives 7-bit yaw; a following LSB refines it to 14 bits. Either way the centre
+	// value faces forwards and both ends reach their limit: 0, 64 and 127 are -45, 0 and +45 degrees
+	auto toYaw = [](int value, int centre) {
+		return value < centre ? minYaw * float (centre - value) / float (centre)
+			: maxYaw * float (value - centre) / float (centre - 1);
+	};
+	auto controller = message.getControllerNumber ();
+	if (controller == yawControllerMSB) {
+		midiYawMSB = message.getControllerValue ();
+		midiYaw = toYaw (midiYawMSB, 64);
+	}
+	else if (controller == yawControllerLSB) {
+		midiYaw = toYaw ((midiYawMSB << 7) | message.getControllerValue (), 8192);
+	}
+	else {
+		return;
+	}
+
+	hasMidiYaw = true;
+}
+
+bool CrossFeedAudioProcessor::isLoudnessMatched (bool isActive) const noexcept
+{
+	// loudness is only compared while the whole block is processed, neither bypassed nor fading
+	// in or out of bypass, so that the output never includes any of the dry signal
+	return isActive && ! wetMix.isSmoothing () && wetMix.getTargetValue () == 1.0f;
+}
+
+void CrossFeedAudioProcessor::processBlock (AudioBuffer<float>& ioBuffer, MidiBuffer& midiMessages)
+{
+	// the output is measured without the makeup, which would otherwise chase itself
+	bool isActive = ! *bypass;
+	bool isMatched = isLoudnessMatched (isActive);
+	auto numSamples = ioBuffer.getNumSamples ();
+	if (isMatched)
+		pushLoudness (loudnessMatcher->input, ioBuffer.getReadPointer (0), ioBuffer.getReadPointer (1), numSamples, 1.0f, 1);
+	processInternal (ioBuffer, midiMessages, isActive);
+	meterFifo.push (ioBuffer.getReadPointer (0), ioBuffer.getReadPointer (1), numSamples);
+	if (isMatched)
+		pushLoudness (loudnessMatcher->output, ioBuffer.getReadPointer (0), ioBuffer.getReadPointer (1), numSamples, 1.0f / makeupGain, 1);
+}
+
+void CrossFeedAudioProcessor::processBlockBypassed (AudioBuffer<float>& ioBuffer, MidiBuffer& midiMessages)
+{
+	processInternal (ioBuffer, midiMessages, false);
+	meterFifo.push (ioBuffer.getReadPointer (0), ioBuffer.getReadPointer (1), ioBuffer.getNumSamples ());
+}
+
+void CrossFeedAudioProcessor::processInterleaved (float* frames, int numFrames, MidiBuffer& midiMessages)
+{
+	bool isActive = ! *bypass;
+	bool isMatched = isLoudnessMatched (isActive);
+	if (isMatched)
+		pushLoudness (loudnessMatcher->input, frames, frames + 1, numFrames, 1.0f, 2);
+	processInterleavedInternal (frames, numFrames, midiMessages, isActive);
+	meterFifo.push (frames, frames + 1, numFrames, 1.0f, 2);
+	if (isMatched)
+		pushLoudness (loudnessMatcher->output, frames, frames + 1, numFrames, 1.0f / makeupGain, 2);
+}
+
+void CrossFeedAudioProcessor::pushLoudness (MeterFifo& fifo, const float* left, const float* right, int numFrames, float gain, int stride)
+{
+	if (! loudnessMatcher->isOffline ()) {
+		fifo.push (left, right, numFrames, gain, stride);
+		return;
+	}
+
+	// offline, the render thread owns the estimator and runs it after each piece, so that the
+	// FIFO never overflows and the makeup depends on nothing but the audio
+	loudnessMatcher->update ();
+	auto maxFrames = loudnessMatcher->getMaxFramesPerUpdate ();
+	for (int start = 0; start < numFrames; start += maxFrames) {
+		auto n = jmin (numFrames - start, maxFrames);
+		fifo.push (left + start * stride, right + start * stride, n, gain, stride);
+		loudnessMatcher->update ();
+	}
+}
+
+dsp::AudioBlock<float> CrossFeedAudioProcessor::copyTail (const dsp::AudioBlock<float>& block, size_t numChannels, size_t length)
+{
+	auto numSamples = block.getNumSamples ();
+	auto n = jmin (numSamples, length, warmUpLength);
+	for (size_t chan = 0; chan < numChannels; ++chan)
+		FloatVectorOperations::copy (tailChannels[chan], block.getChannelPointer (chan) + numSamples - n, int (n));
+	return dsp::AudioBlock<float> (tailChannels.data (), numChannels, n);
+}
+
+bool CrossFeedAudioProcessor::beginBlock (bool isActive, bool hasBus)
+{
+	// a program change swaps in its precomputed coefficients, which the delays and gains glide to
+	if (auto* program = pendingProgram.exchange (nullptr))
+		applyProgram (*program);
+
+	wetMix.setTargetValue (isActive ? 1.0f : 0.0f);
+
+	// A/B comparison renders B alongside A, onto the second bus if there is one and otherwise
+	// into the selection; switched on, B starts afresh
+	bool comparing = isComparing ();
+	if (comparing && ! wasComparing)
+		resetComparison ();
+	wasComparing = comparing;
+	if (comparing && ! hasBus)
+		selectB.setTargetValue (*abSelect ? 1.0f : 0.0f);
+	else
+		selectB.setCurrentAndTargetValue (*abSelect ? 1.0f : 0.0f);
+	return comparing;
+}
+
+void CrossFeedAudioProcessor::processSegmentAB (dsp::AudioBlock<float> segment, dsp::AudioBlock<float> busSegment, bool comparing, float sampleRate)
+{
+	if (comparing) {
+		updateComparison (sampleRate);
+		processSegmentComparison (segment, busSegment);
+	}
+	else {
+		processSegment (segment);
+	}
+}
+
+void CrossFeedAudioProcessor::processSegmentMixed (dsp::AudioBlock<float> segment, dsp::AudioBlock<float> busSegment, bool comparing, bool isFading, float sampleRate)
+{
+	auto length = int (segment.getNumSamples ());
+
+	// while fading both paths run in full
+	dsp::AudioBlock<float> dryBlock (dryChannels.data (), 2, size_t (length));
+	if (isFading) {
+		FloatVectorOperations::copy (dryChannels[0], segment.getChannelPointer (0), length);
+		FloatVectorOperations::copy (dryChannels[1], segment.getChannelPointer (1), length);
+		foldDown (segment, dryChannels[0], dryChannels[1]);
+		dryDelay.process (dsp::ProcessContextReplacing<float> (dryBlock));
+	}
+
+	// update shelving and delay filter parameters
+	updateParameters (sampleRate, length);
+	processSegmentAB (segment, busSegment, comparing, sampleRate);
+
+	if (isFading) {
+		for (size_t chan = 0; chan < 2 + busSegment.getNumChannels (); ++chan) {
+			auto wet = chan < 2 ? segment.getChannelPointer (chan) : busSegment.getChannelPointer (chan - 2);
+			auto dry = dryChannels[chan % 2];
+			auto mix = wetMix;
+			for (int i = 0; i < length; ++i)
+				wet[i] = dry[i] + mix.getNextValue () * (wet[i] - dry[i]);
+		}
+		wetMix.skip (length);
+	}
+}
+
+void CrossFeedAudioProcessor::processInternal (AudioBuffer<float>& ioBuffer, MidiBuffer& midiMessages, bool isActive)
 {
 	ScopedNoDenormals noDenormals;
 	int numSamples = ioBuffer.getNumSamples ();
+	float sampleRate = static_cast<float> (getSampleRate ());
+	auto numChannels = size_t (jmin (getTotalNumInputChannels (), int (maxInputChannels)));
 
-	// update shelving and delay filter parameters
-	updateParameters (static_cast<float> (getSampleRate ()));
+	MidiBuffer::Iterator midiIterator (midiMessages);
+	MidiMessage message;
+	int eventPosition;
+	bool hasEvent = midiIterator.getNextEvent (message, eventPosition);
 
-	// apply delay compensation to main signal 
 	dsp::AudioBlock<float> ioBlock (ioBuffer);
-	lpDelayComp.process (dsp::ProcessContextReplacing<float> (ioBlock));
+	auto stereoBlock = ioBlock.getSubsetChannelBlock (0, 2);
+	bool hasBus = hasComparisonBus && ioBlock.getNumChannels () >= 4;
+	bool comparing = beginBlock (isActive, hasBus);
+	bool isFading = wetMix.isSmoothing ();
+	auto busBlock = hasBus && comparing ? ioBlock.getSubsetChannelBlock (2, 2) : dsp::AudioBlock<float> ();
+	// without a B rendering the second bus carries the main output
+	auto copyToBus = [&] {
+		if (hasBus && busBlock.getNumChannels () == 0) {
+			for (int chan = 0; chan < 2; ++chan)
+				FloatVectorOperations::copy (ioBlock.getChannelPointer (size_t (chan + 2)), ioBlock.getChannelPointer (size_t (chan)), numSamples);
+		}
+	};
 
-	// store crossfeed into an auxilliary buffer
-	auto auxBuffer = AudioBuffer<float> (2, numSamples);
-	auxBuffer.copyFrom (0, 0, ioBuffer, 1, 0, numSamples);
-	auxBuffer.copyFrom (1, 0, ioBuffer, 0, 0, numSamples);
+	// fully bypassed: only the delayed dry signal is heard, with surround input folded down onto
+	// the front pair, and the processing chain is kept warm by running it over the end of the block
+	if (! isFading && ! isActive) {
+		while (hasEvent) {
+			handleMidiEvent (message);
+			hasEvent = midiIterator.getNextEvent (message, eventPosition);
+		}
+		updateParameters (sampleRate, numSamples);
 
-	// lowpass and delay the crossfeed
-	dsp::AudioBlock<float> auxBlock (auxBuffer);
-	lpFilt.process (dsp::ProcessContextReplacing<float> (auxBlock));
-	ITDFilt.process (dsp::ProcessContextReplacing<float> (auxBlock));
-	auxBuffer.applyGain (xGain);	
+		auto tail = copyTail (ioBlock, numChannels, warmUpLength);
+		foldDown (ioBlock, stereoBlock.getChannelPointer (0), stereoBlock.getChannelPointer (1));
+		dryDelay.process (dsp::ProcessContextReplacing<float> (stereoBlock));
+		for (size_t start = 0; start < tail.getNumSamples (); start += maxSegmentSize)
+			processSegmentAB (tail.getSubBlock (start, jmin (size_t (maxSegmentSize), tail.getNumSamples () - start)), {}, comparing, sampleRate);
+		busBlock = {};
+		copyToBus ();
+		return;
+	}
 
-	// add the crossfeed to the main signal
-	ioBlock.add (auxBlock);
-	//ioBlock.multiplyBy (normalise);
+	// fully active: keep the dry delay primed with the end of the block, ready for a fade out
+	dsp::AudioBlock<float> dryTail;
+	if (! isFading) {
+		auto tail = copyTail (ioBlock, numChannels, lpDelay);
+		foldDown (tail, tail.getChannelPointer (0), tail.getChannelPointer (1));
+		dryTail = tail.getSubsetChannelBlock (0, 2);
+	}
 
-	// mid side processing on the output signal
-	stereoToMidSide (ioBuffer);
-	midShelfFilt.process (dsp::ProcessContextReplacing<float> (ioBlock.getSingleChannelBlock (0)));
-	sideShelfFilt.process (dsp::ProcessContextReplacing<float> (ioBlock.getSingleChannelBlock (1)));
-	stereoToMidSide (ioBuffer);
+	// a long offline block goes across the cores whole, once the parameters are taken up as the
+	// first segment would and only if the chain then stays at rest through the block
+	bool isOffline = false;
+	if (! isFading && ! comparing && ! hasEvent && canProcessOffline (numSamples)) {
+		updateParameters (sampleRate, numSamples);
+		isOffline = getChainMotion () != ChainMotion::gliding;
+	}
+	if (isOffline)
+		processOffline (stereoBlock);
+
+	// process the block in short segments, picking up parameter changes at each segment boundary
+	// and splitting further at incoming MIDI events so head tracking applies at the exact sample
+	for (int start = isOffline ? numSamples : 0; start < numSamples;) {
+		while (hasEvent && eventPosition <= start) {
+			handleMidiEvent (message);
+			hasEvent = midiIterator.getNextEvent (message, eventPosition);
+		}
+
+		auto end = jmin (start + maxSegmentSize, numSamples);
+		if (hasEvent && eventPosition < end)
+			end = eventPosition;
 
-	// output gain adjustment
-	ioBlock.multiplyBy (gain);
-	bypassReset = false;
+		auto segment = ioBlock.getSubBlock (size_t (start), size_t (end - start));
+		auto busSegment = busBlock.getNumChannels () > 0 ? busBlock.getSubBlock (size_t (start), size_t (end - start)) : busBlock;
+		processSegmentMixed (segment, busSegment, comparing, isFading, sampleRate);
+		start = end;
+	}
+
+	if (! isFading)
+		dryDelay.process (dsp::ProcessContextReplacing<float> (dryTail));
+	copyToBus ();
+
+	// events stamped past the end of the block still count for the next one
+	while (hasEvent) {
+		handleMidiEvent (message);
+		hasEvent = midiIterator.getNextEvent (message, eventPosition);
+	}
 }
 
-void CrossFeedAudioProcessor::processBlockBypassed (AudioBuffer<float>& buffer, MidiBuffer&)
+void CrossFeedAudioProcessor::processInterleavedInternal (float* frames, int numFrames, MidiBuffer& midiMessages, bool isActive)
 {
-	if (!bypassReset)
-	{
-		lpFilt.reset ();
-		ITDFilt.reset ();
-		lpDelayComp.reset ();
-		midShelfFilt.reset ();
-		sideShelfFilt.reset ();
-		bypassReset = true;
+	jassert (getTotalNumInputChannels () == 2 && numSpeakerPairs == 1);
+	ScopedNoDenormals noDenormals;
+	float sampleRate = static_cast<float> (getSampleRate ());
+
+	MidiBuffer::Iterator midiIterator (midiMessages);
+	MidiMessage message;
+	int eventPosition;
+	bool hasEvent = midiIterator.getNextEvent (message, eventPosition);
+
+	bool comparing = beginBlock (isActive, false);
+	bool isFading = wetMix.isSmoothing ();
+
+	// fully bypassed: only the delayed dry signal is heard, and the chain is kept warm by running
+	// it over the end of the block, as in processInternal
+	if (! isFading && ! isActive) {
+		while (hasEvent) {
+			handleMidiEvent (message);
+			hasEvent = midiIterator.getNextEvent (message, eventPosition);
+		}
+		updateParameters (sampleRate, numFrames);
+
+		auto tailLength = jmin (size_t (numFrames), warmUpLength);
+		auto tail = frames + 2 * (size_t (numFrames) - tailLength);
+		for (size_t i = 0; i < tailLength; ++i) {
+			tailChannels[0][i] = tail[2 * i];
+			tailChannels[1][i] = tail[2 * i + 1];
+		}
+		dryDelay.processStrided (frames, size_t (numFrames), 2);
+		dsp::AudioBlock<float> tailBlock (tailChannels.data (), 2, tailLength);
+		for (size_t start = 0; start < tailLength; start += maxSegmentSize)
+			processSegmentAB (tailBlock.getSubBlock (start, jmin (size_t (maxSegmentSize), tailLength - start)), {}, comparing, sampleRate);
+		return;
+	}
+
+	// fully active: keep the dry delay primed with the end of the block, ready for a fade out
+	size_t tailLength = 0;
+	if (! isFading) {
+		tailLength = jmin (size_t (numFrames), lpDelay, warmUpLength);
+		auto tail = frames + 2 * (size_t (numFrames) - tailLength);
+		for (size_t i = 0; i < tailLength; ++i) {
+			tailChannels[0][i] = tail[2 * i];
+			tailChannels[1][i] = tail[2 * i + 1];
+		}
+	}
+
+	// segments as in processInternal, split at MIDI events
+	for (int start = 0; start < numFrames;) {
+		while (hasEvent && eventPosition <= start) {
+			handleMidiEvent (message);
+			hasEvent = midiIterator.getNextEvent (message, eventPosition);
+		}
+
+		auto end = jmin (start + maxSegmentSize, numFrames);
+		if (hasEvent && eventPosition < end)
+			end = eventPosition;
+		auto length = size_t (end - start);
+		auto segment = frames + 2 * start;
+
+		if (! isFading && ! comparing) {
+			updateParameters (sampleRate, int (length));
+			processSegmentInterleaved (segment, length);
+		}
+		else {
+			// fades and A/B run the planar segment kernel on a planar copy
+			for (size_t i = 0; i < length; ++i) {
+				planarChannels[0][i] = segment[2 * i];
+				planarChannels[1][i] = segment[2 * i + 1];
+			}
+			processSegmentMixed (dsp::AudioBlock<float> (planarChannels.data (), 2, length), {}, comparing, isFading, sampleRate);
+			for (size_t i = 0; i < length; ++i) {
+				segment[2 * i] = planarChannels[0][i];
+				segment[2 * i + 1] = planarChannels[1][i];
+			}
+		}
+		start = end;
+	}
+
+	if (! isFading)
+		dryDelay.process (dsp::ProcessContextReplacing<float> (dsp::AudioBlock<float> (tailChannels.data (), 2, tailLength)));
+
+	// events stamped past the end of the block still count for the next one
+	while (hasEvent) {
+		handleMidiEvent (message);
+		hasEvent = midiIterator.getNextEvent (message, eventPosition);
+	}
+}
+
+bool CrossFeedAudioProcessor::canProcessOffline (int numSamples) const noexcept
+{
+	// the stereo chain only, with the cutoff and shelves settled so the whole block shares its coefficients
+	return isNonRealtime () && numSamples >= offlineBlockThreshold && numSamples <= offlineChannels.getNumSamples ()
+		&& (*offlineWorkers)->getNumThreads () > 1 && numSpeakerPairs == 1 && centreChannel < 0 && lfeChannel < 0
+		&& ! cutoffSmoothed.isSmoothing () && cutoffSmoothed.getTargetValue () == *shadowCutoff
+		&& ! shelfXGaindB.isSmoothing () && shelfXGaindB.getTargetValue () == *xGaindB;
+}
+
+void CrossFeedAudioProcessor::processOffline (dsp::AudioBlock<float> stereoBlock)
+{
+	auto& workers = offlineWorkers->get ();
+	auto numSamples = stereoBlock.getNumSamples ();
+	BlockChunks chunks (numSamples, workers.getNumThreads (), minOfflineChunkLength);
+	const float* in[] = { stereoBlock.getChannelPointer (0), stereoBlock.getChannelPointer (1) };
+	float* out[] = { stereoBlock.getChannelPointer (0), stereoBlock.getChannelPointer (1) };
+	float* aux[] = { offlineChannels.getWritePointer (0), offlineChannels.getWritePointer (1) };
+	float* direct[] = { offlineChannels.getWritePointer (2), offlineChannels.getWritePointer (3) };
+	auto& pair = speakerPairs[0];
+	bool isBiquad = shadowFilt.getNumSections () > 0;
+	if (isBiquad)
+		shadowScan.prepare (shadowFilt, chunks);
+	else
+		lpScan.prepare (lpFilt, chunks);
+	if (ChainConfig::hasShelves) {
+		midShelfScan.prepare (midShelfFilt, chunks);
+		sideShelfScan.prepare (sideShelfFilt, chunks);
+	}
+
+	// the delays and crossfeed gains read the untouched input, and the head shadow runs from rest
+	auto crossfeed = [&](int chunk) {
+		auto start = chunks.getStart (chunk);
+		auto length = chunks.getLength (chunk);
+		for (size_t ear = 0; ear < 2; ++ear) {
+			auto dst = aux[ear] + start;
+			pair.ITDFilt[ear].readBlock (0, in[1 - ear], start, length, dst);
+			FloatVectorOperations::multiply (dst, pair.xGainSmoothed[ear].getTargetValue (), int (length));
+			if (isBiquad)
+				shadowScan.filterChunk (shadowFilt, ear, chunk, dst, dst);
+			else
+				lpScan.filterChunk (lpFilt, ear, chunk, dst, dst);
+			lpDelayComp.readBlock (ear, in[ear], start, length, direct[ear] + start);
+		}
+	};
+	workers.run (chunks.numChunks, crossfeed);
+	if (isBiquad)
+		shadowScan.resolve (shadowFilt, 2);
+	else
+		lpScan.resolve (lpFilt, 2);
+
+	// the input is overwritten from here on, so the delay lines take the end of it now
+	for (size_t ear = 0; ear < 2; ++ear)
+		pair.ITDFilt[ear].writeBlock (&in[1 - ear], numSamples);
+	lpDelayComp.writeBlock (in, numSamples);
+
+	// the head shadow's true start states, the sum, and the shelves from rest in mid and side
+	auto mix = [&](int chunk) {
+		auto start = chunks.getStart (chunk);
+		auto length = chunks.getLength (chunk);
+		for (size_t ear = 0; ear < 2; ++ear) {
+			if (isBiquad)
+				shadowScan.correctChunk (shadowFilt, ear, chunk, aux[ear] + start);
+			else
+				lpScan.correctChunk (lpFilt, ear, chunk, aux[ear] + start);
+			FloatVectorOperations::add (direct[ear] + start, aux[ear] + start, int (length));
+		}
+		if (ChainConfig::hasShelves) {
+			stereoToMidSide (dsp::AudioBlock<float> (direct, 2, start, length));
+			midShelfScan.filterChunk (midShelfFilt, 0, chunk, direct[0] + start, direct[0] + start);
+			sideShelfScan.filterChunk (sideShelfFilt, 0, chunk, direct[1] + start, direct[1] + start);
+		}
+	};
+	workers.run (chunks.numChunks, mix);
+	for (size_t chan = 0; chan < 2; ++chan)
+		lastCrossfeed[chan] = aux[chan][numSamples - 1];
+	if (ChainConfig::hasShelves) {
+		midShelfScan.resolve (midShelfFilt, 1);
+		sideShelfScan.resolve (sideShelfFilt, 1);
+	}
+
+	// the shelves' true start states, and the output gain into the block
+	auto gainTarget = ChainConfig::hasOutputGain ? gain.getTargetValue () : 1.0f;
+	auto finish = [&](int chunk) {
+		auto start = chunks.getStart (chunk);
+		auto length = chunks.getLength (chunk);
+		if (ChainConfig::hasShelves) {
+			midShelfScan.correctChunk (midShelfFilt, 0, chunk, direct[0] + start);
+			sideShelfScan.correctChunk (sideShelfFilt, 0, chunk, direct[1] + start);
+			stereoToMidSide (dsp::AudioBlock<float> (direct, 2, start, length));
+		}
+		for (size_t chan = 0; chan < 2; ++chan)
+			FloatVectorOperations::multiply (out[chan] + start, direct[chan] + start, gainTarget, int (length));
+	};
+	workers.run (chunks.numChunks, finish);
+}
+
+ChainMotion CrossFeedAudioProcessor::getChainMotion () const noexcept
+{
+	// checked after the segment's parameter update, which may have started a crossfade or a ramp
+	if (gain.isSmoothing ())
+		return ChainMotion::gliding;
+	for (size_t p = 0; p < numSpeakerPairs; ++p) {
+		for (size_t ear = 0; ear < 2; ++ear) {
+			if (speakerPairs[p].ITDFilt[ear].isCrossfading () || speakerPairs[p].xGainSmoothed[ear].isSmoothing ())
+				return ChainMotion::gliding;
+		}
+	}
+	return gain.getTargetValue () == 1.0f ? ChainMotion::steadyUnity : ChainMotion::steady;
+}
+
+void CrossFeedAudioProcessor::processSegment (dsp::AudioBlock<float> ioBlock)
+{
+	bool surround = numSpeakerPairs > 1 || centreChannel >= 0 || lfeChannel >= 0;
+	selectChain (surround, shadowFilt.getNumSections () > 0, getChainMotion (), [this, ioBlock](auto chain) {
+		runChain<decltype (chain)> (ioBlock);
+	});
+}
+
+void CrossFeedAudioProcessor::processSegmentComparison (dsp::AudioBlock<float> ioBlock, dsp::AudioBlock<float> busBlock)
+{
+	// one variant for both settings: steady only once neither is gliding
+	auto motion = getChainMotion ();
+	if (motion != ChainMotion::gliding) {
+		bool bGliding = comparison.gain.isSmoothing ();
+		for (size_t ear = 0; ear < 2; ++ear)
+			bGliding = bGliding || comparison.ITDFilt[ear].isCrossfading () || comparison.xGainSmoothed[ear].isSmoothing ();
+		if (bGliding)
+			motion = ChainMotion::gliding;
+		else if (comparison.gain.getTargetValue () != 1.0f)
+			motion = ChainMotion::steady;
+	}
+	auto run = [this, ioBlock, busBlock](auto chain) {
+		runComparison<decltype (chain)> (ioBlock, busBlock);
+	};
+	ChainSelection::withShadow<false> (shadowFilt.getNumSections () > 0, motion, run);
+}
+
+template <typename Chain>
+void CrossFeedAudioProcessor::runComparison (dsp::AudioBlock<float> ioBlock, dsp::AudioBlock<float> busBlock)
+{
+	auto numSamples = ioBlock.getNumSamples ();
+	auto n = int (numSamples);
+	jassert (numSamples <= size_t (maxSegmentSize));
+	auto outBlock = ioBlock.getSubsetChannelBlock (0, 2);
+
+	// B first, on a copy of the input, through the stages of runChain in the same order
+	auto bBlock = busBlock.getNumChannels () > 0 ? busBlock : dsp::AudioBlock<float> (comparisonChannels.data (), 2, numSamples);
+	auto bCrossfeed = dsp::AudioBlock<float> (pairChannels.data (), 2, numSamples);
+	for (size_t chan = 0; chan < 2; ++chan) {
+		FloatVectorOperations::copy (bBlock.getChannelPointer (chan), outBlock.getChannelPointer (chan), n);
+		FloatVectorOperations::copy (bCrossfeed.getChannelPointer (chan), outBlock.getChannelPointer (1 - chan), n);
+	}
+	for (size_t ear = 0; ear < 2; ++ear) {
+		auto earBlock = bCrossfeed.getSingleChannelBlock (ear);
+		comparison.ITDFilt[ear].process<Chain::gliding> (dsp::ProcessContextReplacing<float> (earBlock));
+		if (Chain::gliding)
+			comparison.xGainSmoothed[ear].applyGain (earBlock.getChannelPointer (0), n);
+		else
+			FloatVectorOperations::multiply (earBlock.getChannelPointer (0), comparison.xGainSmoothed[ear].getTargetValue (), n);
+	}
+	comparison.lpDelayComp.process<false> (dsp::ProcessContextReplacing<float> (bBlock));
+	if (Chain::biquadShadow)
+		comparison.shadowFilt.process (dsp::ProcessContextReplacing<float> (bCrossfeed));
+	else
+		comparison.lpFilt.process (dsp::ProcessContextReplacing<float> (bCrossfeed));
+	for (size_t chan = 0; chan < 2; ++chan)
+		comparison.lastCrossfeed[chan] = bCrossfeed.getChannelPointer (chan)[numSamples - 1];
+	bBlock.add (bCrossfeed);
+	if (Chain::shelves) {
+		stereoToMidSide (bBlock);
+		comparison.midShelfFilt.process (dsp::ProcessContextReplacing<float> (bBlock.getSingleChannelBlock (0)));
+		comparison.sideShelfFilt.process (dsp::ProcessContextReplacing<float> (bBlock.getSingleChannelBlock (1)));
+		stereoToMidSide (bBlock);
+	}
+	if (Chain::outputGain) {
+		if (Chain::gliding) {
+			auto rightGain = comparison.gain;
+			comparison.gain.applyGain (bBlock.getChannelPointer (0), n);
+			rightGain.applyGain (bBlock.getChannelPointer (1), n);
+		}
+		else {
+			bBlock.multiplyBy (comparison.gain.getTargetValue ());
+		}
+	}
+
+	// then A in place, exactly as without the comparison
+	runChain<Chain> (ioBlock);
+
+	// without a second bus the selection is heard, crossfading when it changes
+	if (busBlock.getNumChannels () > 0)
+		return;
+	if (selectB.isSmoothing ()) {
+		for (size_t chan = 0; chan < 2; ++chan) {
+			auto a = outBlock.getChannelPointer (chan);
+			auto b = comparisonChannels[chan];
+			auto mix = selectB;
+			for (int i = 0; i < n; ++i)
+				a[i] += mix.getNextValue () * (b[i] - a[i]);
+		}
+		selectB.skip (n);
+	}
+	else if (selectB.getTargetValue () > 0.5f) {
+		for (size_t chan = 0; chan < 2; ++chan)
+			FloatVectorOperations::copy (outBlock.getChannelPointer (chan), comparisonChannels[chan], n);
+	}
+}
+
+void CrossFeedAudioProcessor::processSegmentInterleaved (float* frames, size_t numFrames)
+{
+	// stereo only, so the surround variants are never instantiated
+	auto run = [this, frames, numFrames](auto chain) {
+		runChainInterleaved<decltype (chain)> (frames, numFrames);
+	};
+	ChainSelection::withShadow<false> (shadowFilt.getNumSections () > 0, getChainMotion (), run);
+}
+
+template <typename Chain>
+void CrossFeedAudioProcessor::runChainInterleaved (float* frames, size_t numFrames)
+{
+	// runChain for the front pair alone, with every stage stepping through L/R pairs
+	static_assert (! Chain::surround, "Interleaved frames are stereo");
+	jassert (numFrames <= size_t (maxSegmentSize));
+	auto n = int (numFrames);
+	auto& pair = speakerPairs[0];
+	auto aux = interleavedAux;
+
+	// each ear hears the opposite speaker, through its own ITD and gain
+	for (size_t i = 0; i < 2 * numFrames; i += 2) {
+		aux[i] = frames[i + 1];
+		aux[i + 1] = frames[i];
+	}
+	for (size_t ear = 0; ear < 2; ++ear) {
+		pair.ITDFilt[ear].processStrided<Chain::gliding> (aux + ear, numFrames, 2);
+		auto& xGainSmoothed = pair.xGainSmoothed[ear];
+		if (Chain::gliding && xGainSmoothed.isSmoothing ()) {
+			for (size_t i = ear; i < 2 * numFrames; i += 2)
+				aux[i] *= xGainSmoothed.getNextValue ();
+		}
+		else {
+			auto g = xGainSmoothed.getTargetValue ();
+			for (size_t i = ear; i < 2 * numFrames; i += 2)
+				aux[i] *= g;
+		}
+	}
+
+	// delay compensation, head shadow and the sum, as in runChain
+	lpDelayComp.processStrided<false> (frames, numFrames, 2);
+	if (Chain::biquadShadow)
+		shadowFilt.processInterleaved (aux, numFrames);
+	else
+		lpFilt.processStrided (aux, numFrames, 2);
+	lastCrossfeed = { aux[2 * numFrames - 2], aux[2 * numFrames - 1] };
+	FloatVectorOperations::add (frames, aux, 2 * n);
+
+	// mid side shelves, mid in the left lane and side in the right
+	if (Chain::shelves) {
+		stereoToMidSide (frames, numFrames);
+		midShelfFilt.processStrided (frames, numFrames, 2);
+		sideShelfFilt.processStrided (frames + 1, numFrames, 2);
+		stereoToMidSide (frames, numFrames);
+	}
+
+	// output gain, one ramp step per frame for both channels
+	if (! Chain::outputGain)
+		return;
+	if (Chain::gliding && gain.isSmoothing ()) {
+		for (size_t i = 0; i < 2 * numFrames; i += 2) {
+			auto g = gain.getNextValue ();
+			frames[i] *= g;
+			frames[i + 1] *= g;
+		}
+	}
+	else {
+		FloatVectorOperations::multiply (frames, gain.getTargetValue (), 2 * n);
+	}
+}
+
+template <typename Chain>
+void CrossFeedAudioProcessor::runChain (dsp::AudioBlock<float> ioBlock)
+{
+	auto numSamples = ioBlock.getNumSamples ();
+	auto n = int (numSamples);
+	jassert (numSamples <= size_t (maxSegmentSize));
+	auto outBlock = ioBlock.getSubsetChannelBlock (0, 2);
+	float* outL = outBlock.getChannelPointer (0);
+	float* outR = outBlock.getChannelPointer (1);
+
+	// fold centre and LFE into the front pair as a phantom centre
+	if (Chain::surround) {
+		for (auto c : { centreChannel, lfeChannel }) {
+			if (c >= 0) {
+				FloatVectorOperations::addWithMultiply (outL, ioBlock.getChannelPointer (size_t (c)), inverseSqrtTwo, n);
+				FloatVectorOperations::addWithMultiply (outR, ioBlock.getChannelPointer (size_t (c)), inverseSqrtTwo, n);
+			}
+		}
+	}
+
+	// store the crossfeed of every speaker pair into the auxilliary buffer, each with its own ITD
+	// and gain; the lowpass is linear and shared, so it runs once on the sum afterwards
+	auto auxBlock = dsp::AudioBlock<float> (auxChannels.data (), 2, numSamples);
+	auto pairBlock = dsp::AudioBlock<float> (pairChannels.data (), 2, numSamples);
+	auto numPairs = Chain::surround ? numSpeakerPairs : 1;
+	for (size_t p = 0; p < numPairs; ++p) {
+		auto& pair = speakerPairs[p];
+		auto dst = p == 0 ? auxBlock : pairBlock;
+		auto l = ioBlock.getChannelPointer (size_t (pair.leftChannel));
+		auto r = ioBlock.getChannelPointer (size_t (pair.rightChannel));
+		FloatVectorOperations::copy (dst.getChannelPointer (0), r, n);
+		FloatVectorOperations::copy (dst.getChannelPointer (1), l, n);
+
+		for (size_t ear = 0; ear < 2; ++ear) {
+			auto earBlock = dst.getSingleChannelBlock (ear);
+			pair.ITDFilt[ear].process<Chain::gliding> (dsp::ProcessContextReplacing<float> (earBlock));
+			if (Chain::gliding)
+				pair.xGainSmoothed[ear].applyGain (earBlock.getChannelPointer (0), n);
+			else
+				FloatVectorOperations::multiply (earBlock.getChannelPointer (0), pair.xGainSmoothed[ear].getTargetValue (), n);
+		}
+
+		// surround pairs mix into the headphone signal: direct to the near ear, crossfeed to the far one
+		if (p > 0) {
+			FloatVectorOperations::add (outL, l, n);
+			FloatVectorOperations::add (outR, r, n);
+			auxBlock.add (pairBlock);
+		}
+	}
+
+	// apply delay compensation to main signal 
+	lpDelayComp.process<false> (dsp::ProcessContextReplacing<float> (outBlock));
+
+	// lowpass the crossfeed with the selected head-shadow model
+	if (Chain::biquadShadow)
+		shadowFilt.process (dsp::ProcessContextReplacing<float> (auxBlock));
+	else
+		lpFilt.process (dsp::ProcessContextReplacing<float> (auxBlock));
+	for (size_t chan = 0; chan < 2; ++chan)
+		lastCrossfeed[chan] = auxChannels[chan][numSamples - 1];
+
+	// add the crossfeed to the main signal
+	outBlock.add (auxBlock);
+	//outBlock.multiplyBy (normalise);
+
+	// mid side processing on the output signal
+	if (Chain::shelves) {
+		stereoToMidSide (outBlock);
+		midShelfFilt.process (dsp::ProcessContextReplacing<float> (outBlock.getSingleChannelBlock (0)));
+		sideShelfFilt.process (dsp::ProcessContextReplacing<float> (outBlock.getSingleChannelBlock (1)));
+		stereoToMidSide (outBlock);
+	}
+
+	// output gain adjustment, ramping both channels alike
+	if (! Chain::outputGain)
+		return;
+	if (Chain::gliding) {
+		auto rightGain = gain;
+		gain.applyGain (outL, n);
+		rightGain.applyGain (outR, n);
+	}
+	else {
+		outBlock.multiplyBy (gain.getTargetValue ());
 	}
-	return;
 }
 
 //==============================================================================
@@ -2,13 +2,20 @@
 
 #include <JuceHeader.h>
 #include "Delay.h"
+#include "Filters.h"
+#include "FixedPoint.h"
+#include "Loudness.h"
+#include "Response.h"
+#include "Analyser.h"
+#include "Chain.h"
+#include "Parallel.h"
+#include "StateArena.h"
 
 //==============================================================================
 /**
 */
 class CrossFeedAudioProcessor : public AudioProcessor
 {
-	using MultiChannelIIRFilter = dsp::ProcessorDuplicator<dsp::IIR::Filter<float>, dsp::IIR::Coefficients<float>>;
 	using MultiChannelFIRFilter = dsp::ProcessorDuplicator <dsp::FIR::Filter <float>, dsp::FIR::Coefficients<float>>;
 
 public:
@@ -21,6 +28,8 @@ public:
 	// Main processing
 	void prepareToPlay (double sampleRate, int samplesPerBlock) override;
 	void releaseResources () override;
+	// Offline, the render thread runs the loudness estimator itself
+	void setNonRealtime (bool isNonRealtime) noexcept override;
 
 #ifndef JucePlugin_PreferredChannelConfigurations
 	bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
@@ -29,6 +38,11 @@ public:
 	void processBlock (AudioBuffer<float>&, MidiBuffer&) override;
 	void processBlockBypassed (AudioBuffer<float>&, MidiBuffer&) override;
 
+	// Stereo only: processes interleaved frames in place, the left sample of frame i at frames[2 i],
+	// for hosts that hold their audio that way. Gives the same output as processBlock; while the
+	// chain is active every stage walks the frames as L/R pairs, so nothing is de-interleaved.
+	void processInterleaved (float* frames, int numFrames, MidiBuffer& midiMessages);
+
 	//==============================================================================
 	// Create or check GUI
 	AudioProcessorEditor* createEditor () override;
@@ -53,11 +67,60 @@ public:
 	void getStateInformation (MemoryBlock& destData) override;
 	void setStateInformation (const void* data, int sizeInBytes) override;
 
-	// User editable parameters
+	// Factory programs; switching between them swaps in coefficients precomputed in prepareToPlay
+	struct Program {
+		const char* name;
+		float gaindB;
+		float xGaindB;
+		float angle;
+	};
+	static constexpr int numPrograms { 4 };
+	static const Program programs[numPrograms];
+
+	// Current parameters of the front pair, for running the chain in FixedPointCrossFeed. Only the
+	// first order shadow model exists in fixed point.
+	FixedPointSettings getFixedPointSettings () const noexcept;
+
+	// Analytic response of the front pair for the current parameter values on a grid set up at the
+	// current sample rate, with the latency taken out so the phase reads against the direct path.
+	// Works from its own copy of the coefficients, so the editor may call it once prepared.
+	void computeResponse (const ResponseGrid& grid, ResponseCurves& curves) const;
+
+	// Delay requests clamped to a line's capacity since construction; nonzero means a delay was wrong
+	size_t getNumClampedDelays () const noexcept;
+
+	// Bytes held by this instance: the object itself, with its inline delay lines, the arena's
+	// filter state, coefficients and scratch, and the meter and loudness FIFOs
+	size_t getStateMemoryBytes () const noexcept {
+		return sizeof (*this) + arena.getCapacity () + meterFifo.getMemoryBytes () + loudnessMatcher->getMemoryBytes ();
+	}
+
+	// Tap of the output for the editor's meters, fed at the end of every block once enabled
+	MeterFifo meterFifo;
+
+	// User editable parameters. A fixed-configuration build (see Chain.h) does not add GAIN,
+	// AUTOGAIN and BGAIN without the output gain stage, or ORDER with the model pinned; they are
+	// still here, fixed at their defaults, but the host never sees them.
 	AudioParameterFloat* gaindB;
 	AudioParameterFloat* xGaindB;
 	AudioParameterFloat* angle;
+	AudioParameterFloat* headYaw;
+	AudioParameterFloat* headWidth;
+	AudioParameterFloat* shadowCutoff;
+	AudioParameterChoice* shadowOrder;
+	AudioParameterBool* headTracking;
 	AudioParameterBool* bypass;
+	AudioParameterBool* autoGain;
+	// A/B comparison: a second setting of gain, crossfeed gain and angle rendered alongside the
+	// first, heard through the selection or on the second output bus
+	AudioParameterBool* abCompare;
+	AudioParameterBool* abSelect;
+	AudioParameterFloat* bGaindB;
+	AudioParameterFloat* bXGaindB;
+	AudioParameterFloat* bAngle;
+
+	// Makes B the current A setting, to compare against changes to A
+	void copyAToB ();
 
 	// default parameters
 	static constexpr float defaultGaindB { 0.0f };
@@ -72,46 +135,284 @@ public:
 	static constexpr float minAngle { 30.0f };
 	static constexpr float maxAngle { 90.0f };
 
+	static constexpr float defaultYaw { 0.0f };
+	static constexpr float minYaw { -45.0f };
+	static constexpr float maxYaw { 45.0f };
+
+	static constexpr float defaultHeadWidth { 16.0f };
+	static constexpr float minHeadWidth { 12.0f };
+	static constexpr float maxHeadWidth { 20.0f };
+
+	static constexpr float defaultShadowCutoff { 700.0f };
+	static constexpr float minShadowCutoff { 400.0f };
+	static constexpr float maxShadowCutoff { 1200.0f };
+
+	// head-shadow model: the single-pole lowpass, a 2nd order lowpass, or that plus a high shelf
+	static constexpr int numShadowOrders { 3 };
+	static constexpr int defaultShadowOrder { 0 };
+
+	// MIDI controllers carrying head-tracker yaw, as a 14-bit MSB/LSB pair on any channel
+	static constexpr int yawControllerMSB { 16 };
+	static constexpr int yawControllerLSB { 48 };
+
 private:
 
 	static constexpr float pi = MathConstants<float>::pi;
 
-	// Output gain
-	float gain { 1.0f };
+	// Parameters this build leaves out, which the base class does not own since they were never added
+	OwnedArray<AudioProcessorParameter> unusedParameters;
+
+	// Output gain, ramped so that automation and program changes do not step
+	SmoothedValue<float> gain { 1.0f };
+	static constexpr float gainRampTime { 0.005f };
+	// Auto gain: makeup that matches the output's loudness to the input's, folded into the output
+	// gain so it costs nothing per sample; 1 while auto gain is off
+	std::unique_ptr<LoudnessMatcher> loudnessMatcher;
+	float makeupGain { 1.0f };
 	// Crossfeed gain before being added to input
 	float xGain { 0.5f };
 	// Normalisation factor to eliminate level change when crossfeed is added to input
 	float normalise { 1.0f / std::sqrt (1.0f + xGain * xGain) };
 
 	/* Parameters for delay */
-	// Number of samples of delay
-	size_t nsamps { 0 };
-	// Interaural separation in seconds using speed of sound = 340 m/s and head width = 16cm
-	static constexpr float headTime { static_cast<float> (0.0004705882352941176470588L) };
+	// Speed of sound in m/s, converting the head width in cm to an interaural separation in seconds
+	static constexpr float speedOfSound { 340.0f };
+	// Time over which a change of ITD is crossfaded, so the angle can be modulated without clicks
+	static constexpr float itdCrossfadeTime { 0.005f };
 
 	/* Lowpass filter */
-	// Cutoff frequency in Hz
-	static constexpr float wc = { 700.0f };
+	// Cutoff frequency in Hz, glided so the coefficients can follow automation segment by segment
+	SmoothedValue<float> cutoffSmoothed;
+	static constexpr float cutoffRampTime { 0.02f };
 	// Lowpass filter object.
-	MultiChannelIIRFilter lpFilt;
-	// Amount of delay compensation applied
+	FirstOrderFilter<float> lpFilt;
+	// Higher order head shadow, used instead of lpFilt when selected
+	static constexpr size_t maxShadowSections { 2 };
+	BiquadCascade<float, maxShadowSections> shadowFilt;
+	// The shelved model adds a high shelf to the 2nd order lowpass, for the extra attenuation of
+	// the head above a few kHz; it is not a 4th order lowpass
+	static constexpr float shadowShelfFrequency { 2000.0f };
+	static constexpr float shadowShelfdB { -6.0f };
+	// Last filtered crossfeed sample, used to start a newly selected model without a step
+	std::array<float, 2> lastCrossfeed {};
+	// Amount of delay compensation applied, fixed at the group delay of the lowest cutoff so the
+	// latency does not move; higher cutoffs make up the difference in the crossfeed delay
 	size_t lpDelay;
 
 	/* Shelving filters for mid-side processing of output */
-	dsp::IIR::Filter<float> midShelfFilt;
-	dsp::IIR::Filter<float> sideShelfFilt;
+	FirstOrderFilter<float> midShelfFilt;
+	FirstOrderFilter<float> sideShelfFilt;
+	// Crossfeed gain in dB the shelves are computed for, glided over the crossfeed gain's own ramp
+	// so that automation and program changes move the shelves segment by segment rather than at once
+	SmoothedValue<float> shelfXGaindB;
 	
 
+	/* Delay capacities */
+	// Every delay is bounded at the highest supported rate, so all of them are held inline. At
+	// 384 kHz the compensation is 231 samples and the ITD of the widest head adds 225.
+	static constexpr double maxSampleRate { 384000.0 };
+	static constexpr size_t compensationCapacity { 256 };
+	static constexpr size_t ITDCapacity { 512 };
+	using CompensationDelay = InlineDelay<float, compensationCapacity, 2>;
+	using ITDDelay = InlineDelay<float, ITDCapacity, 1>;
+
 	// Delay filter
-	Delay<float> lpDelayComp, ITDFilt;
+	CompensationDelay lpDelayComp;
+	static constexpr float xGainRampTime { 0.002f };
+	// Extra head shadow in dB for a speaker moved to full lateral incidence
+	static constexpr float yawShadowdB { -6.0f };
+
+	/* Virtual speakers */
+	// Crossfeed path of a symmetric pair of virtual speakers. Channel 0 of the path carries the
+	// right speaker to the left ear; the ITD and gain differ per ear when the head is turned.
+	struct SpeakerPair {
+		int leftChannel { 0 };
+		int rightChannel { 1 };
+		// Angle of the right speaker from the nose in degrees, or 0 to follow the angle parameter
+		float azimuth { 0.0f };
+		std::array<ITDDelay, 2> ITDFilt;
+		std::array<SmoothedValue<float>, 2> xGainSmoothed;
+	};
+	// The front pair is always first; surround layouts add side and rear pairs
+	static constexpr size_t maxSpeakerPairs { 3 };
+	static constexpr size_t maxInputChannels { 8 };
+	std::array<SpeakerPair, maxSpeakerPairs> speakerPairs;
+	size_t numSpeakerPairs { 1 };
+	// Centre and LFE are folded into the front pair as a phantom centre; -1 when absent
+	int centreChannel { -1 };
+	int lfeChannel { -1 };
+	void setUpSpeakerPairs ();
+
+	/* Coefficient sets */
+	// Everything the chain needs for one combination of parameters at the current sample rate
+	struct CoefficientSet {
+		float gain { 1.0f };
+		std::array<std::array<size_t, 2>, maxSpeakerPairs> ITDs {};
+		std::array<std::array<float, 2>, maxSpeakerPairs> xGains {};
+		FirstOrderCoefficients<float> lowpass;
+		std::array<BiquadCoefficients<float>, maxShadowSections> shadowSections {};
+		size_t numShadowSections { 0 };
+		float shadowGroupDelay { 0.0f };
+		size_t shadowDelay { 0 };
+		FirstOrderCoefficients<float> midShelf;
+		FirstOrderCoefficients<float> sideShelf;
+	};
+	CoefficientSet coefficients;
+	void computeGain (float newGaindB, CoefficientSet& target) const noexcept;
+	void computeShadow (float newCutoff, int newOrder, float sampleRate, CoefficientSet& target) const noexcept;
+	void computeCrossfeed (float newAngle, float newYaw, float newXGaindB, float newHeadWidth, float sampleRate, CoefficientSet& target) const noexcept;
+	void computeShelves (float newXGaindB, CoefficientSet& target) const noexcept;
+	void applyCoefficients (const CoefficientSet& source) noexcept;
+
+	/* Programs */
+	struct ProgramState {
+		float gaindB;
+		float xGaindB;
+		float angle;
+		float headWidth;
+		float cutoff;
+		int shadowOrder;
+		CoefficientSet coefficients;
+	};
+	std::array<ProgramState, numPrograms> programStates;
+	// Set by setCurrentProgram and picked up by the audio thread at the start of the next block
+	std::atomic<const ProgramState*> pendingProgram { nullptr };
+	std::atomic<int> currentProgram { 0 };
+	void applyProgram (const ProgramState& program) noexcept;
+
+	/* Head tracking */
+	// Yaw most recently received over MIDI, in degrees
+	float midiYaw { defaultYaw };
+	bool hasMidiYaw { false };
+	int midiYawMSB { 64 };
+	void handleMidiEvent (const MidiMessage& message) noexcept;
 	// Minimum delay
 	size_t minDelay;
 
 	// Mid-side transcoder
-	void stereoToMidSide (AudioBuffer<float> buffer);
+	void stereoToMidSide (dsp::AudioBlock<float> block);
+	void stereoToMidSide (float* frames, size_t numFrames) noexcept;
+	// Adds the centre, LFE and surround channels of source to left and right the way runChain's
+	// direct paths do, without the crossfeed: the passive fold-down bypass plays
+	void foldDown (const dsp::AudioBlock<float>& source, float* left, float* right) const noexcept;
+
+	/* Sub-block processing */
+	// Parameters are re-read at most every maxSegmentSize samples, so automation is resolved
+	// independently of the host buffer size
+	static constexpr int maxSegmentSize { 32 };
+	// Scratch space for the crossfeed of a single segment, and of a surround pair within it
+	std::array<float*, 2> auxChannels {};
+	std::array<float*, 2> pairChannels {};
+	// The same for interleaved segments, whose fades and A/B go through planar copies
+	float* interleavedAux { nullptr };
+	std::array<float*, 2> planarChannels {};
+	// Last parameter values the coefficients were computed for, used to skip redundant updates
+	float lastGaindB { std::numeric_limits<float>::quiet_NaN () };
+	float lastXGaindB { std::numeric_limits<float>::quiet_NaN () };
+	float lastAngle { std::numeric_limits<float>::quiet_NaN () };
+	float lastYaw { std::numeric_limits<float>::quiet_NaN () };
+	float lastHeadWidth { std::numeric_limits<float>::quiet_NaN () };
+	float lastCutoff { std::numeric_limits<float>::quiet_NaN () };
+	float lastShelfXGaindB { std::numeric_limits<float>::quiet_NaN () };
+	int lastShadowOrder { -1 };
+
+	/* A/B comparison */
+	// B's own copy of every stage of the stereo chain. A runs through runChain untouched, and B
+	// through the same stages in the same order on a copy of the input, so that neither output
+	// changes when the comparison is switched on or the selection is toggled.
+	struct ComparisonPath {
+		std::array<ITDDelay, 2> ITDFilt;
+		std::array<SmoothedValue<float>, 2> xGainSmoothed;
+		CompensationDelay lpDelayComp;
+		FirstOrderFilter<float> lpFilt;
+		BiquadCascade<float, maxShadowSections> shadowFilt;
+		std::array<float, 2> lastCrossfeed {};
+		FirstOrderFilter<float> midShelfFilt;
+		FirstOrderFilter<float> sideShelfFilt;
+		SmoothedValue<float> gain { 1.0f };
+		CoefficientSet coefficients;
+		float lastGaindB { std::numeric_limits<float>::quiet_NaN () };
+		float lastXGaindB { std::numeric_limits<float>::quiet_NaN () };
+		float lastAngle { std::numeric_limits<float>::quiet_NaN () };
+	};
+	ComparisonPath comparison;
+	// B output of a segment when there is no second bus to take it
+	std::array<float*, 2> comparisonChannels {};
+	// Set when A's shared parameters change, so B follows them at its next update
+	bool comparisonIsStale { true };
+	// Crossfade from A (0) to B (1) when the selection changes
+	SmoothedValue<float> selectB;
+	static constexpr float abFadeTime { 0.01f };
+	// Only stereo input has a B rendering; it goes to the second output bus when that is enabled
+	bool isComparing () const noexcept;
+	bool hasComparisonBus { false };
+	bool wasComparing { false };
+	void updateComparison (float sampleRate);
+	void resetComparison ();
+
+	/* State arena */
+	// Filter state, coefficients and scratch space live contiguously in here; the delay lines are inline
+	StateArena arena;
+	void layOutState (StateArena& target);
+	void resetState ();
+
+	/* Bypass */
+	// Dry signal delayed by the reported latency, so bypassing does not shift it in time
+	CompensationDelay dryDelay;
+	std::array<float*, 2> dryChannels {};
+	// Fades between the dry and processed signals when bypass is toggled
+	SmoothedValue<float> wetMix;
+	static constexpr float bypassFadeTime { 0.005f };
+	// While one path is inactive it is kept warm by running it over only the end of each block
+	// (the filters forget older input within a few time constants); this many samples suffice
+	size_t warmUpLength { 0 };
+	static constexpr float warmUpTimeConstants { 8.0f };
+	std::array<float*, maxInputChannels> tailChannels {};
+	dsp::AudioBlock<float> copyTail (const dsp::AudioBlock<float>& block, size_t numChannels, size_t length);
+
+	/* Offline rendering */
+	// Long blocks rendered offline with the chain at rest are split into chunks across the shared
+	// worker threads: the delays and gains are independent per sample, and the recurrences run
+	// chunk by chunk from rest and are then corrected for their true start states (ChunkScan)
+	static constexpr int offlineBlockThreshold { 8192 };
+	static constexpr size_t minOfflineChunkLength { 2048 };
+	std::unique_ptr<SharedResourcePointer<OfflineWorkers>> offlineWorkers;
+	// crossfeed and direct paths of the whole block
+	AudioBuffer<float> offlineChannels;
+	ChunkScan<float, 1> lpScan;
+	ChunkScan<float, 2 * maxShadowSections> shadowScan;
+	ChunkScan<float, 1, 1> midShelfScan;
+	ChunkScan<float, 1, 1> sideShelfScan;
+	bool canProcessOffline (int numSamples) const noexcept;
+	void processOffline (dsp::AudioBlock<float> stereoBlock);
+
+	void inline updateParameters (float sampleRate, int numSamples);
+	void processInternal (AudioBuffer<float>& ioBuffer, MidiBuffer& midiMessages, bool isActive);
+	// Per-block setup shared by both entry points: a pending program, the wet/dry target and the
+	// A/B comparison. Returns whether B is rendered.
+	bool beginBlock (bool isActive, bool hasBus);
+	// A segment of either entry point's planar path: the parameter update, the chain (with B when
+	// comparing) and, while fading, the delayed dry signal mixed in
+	void processSegmentMixed (dsp::AudioBlock<float> segment, dsp::AudioBlock<float> busSegment, bool comparing, bool isFading, float sampleRate);
+	void processSegmentAB (dsp::AudioBlock<float> segment, dsp::AudioBlock<float> busSegment, bool comparing, float sampleRate);
+	void processSegment (dsp::AudioBlock<float> ioBlock);
+	void processSegmentComparison (dsp::AudioBlock<float> ioBlock, dsp::AudioBlock<float> busBlock);
+	void processInterleavedInternal (float* frames, int numFrames, MidiBuffer& midiMessages, bool isActive);
+	bool isLoudnessMatched (bool isActive) const noexcept;
+	void pushLoudness (MeterFifo& fifo, const float* left, const float* right, int numFrames, float gain, int stride);
+	void processSegmentInterleaved (float* frames, size_t numFrames);
 
-	void inline updateParameters (float sampleRate);
-	bool bypassReset = false; // when set to false the plugin has been bypassed and filters need to be reset
+	/* Chain variants */
+	// The segment functions pick the ChainPolicy for the current state and run these instantiations
+	ChainMotion getChainMotion () const noexcept;
+	template <typename Chain>
+	void runChain (dsp::AudioBlock<float> ioBlock);
+	template <typename Chain>
+	void runChainInterleaved (float* frames, size_t numFrames);
+	template <typename Chain>
+	void runComparison (dsp::AudioBlock<float> ioBlock, dsp::AudioBlock<float> busBlock);
+	// The ORDER parameter, unless a fixed build pins the model
+	int getShadowOrder () const noexcept;
 
 	// lookup tables for fast computation of functions
 	static constexpr float inverseSqrtTwo { static_cast <float> (0.70710678118654752440L) };
@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+	Response.h
+	Created: 19 Oct 2026 8:41:03pm
+	Author:  Abhinav Natarajan
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Log-spaced frequencies at which responses are evaluated, with cos and sin of each in radians per
+// sample precomputed for the filters' applyToResponse.
+struct ResponseGrid {
+	std::vector<float> frequencies;
+	std::vector<float> cosW;
+	std::vector<float> sinW;
+	float sampleRate { 0.0f };
+
+	/** Points stop short of Nyquist, so there may be fewer than numPoints. */
+	void setUp (size_t numPoints, float minFrequency, float maxFrequency, float newSampleRate) {
+		jassert (numPoints > 1 && minFrequency > 0.0f && maxFrequency > minFrequency);
+		sampleRate = newSampleRate;
+		frequencies.clear ();
+		cosW.clear ();
+		sinW.clear ();
+		auto ratio = std::log (maxFrequency / minFrequency);
+		for (size_t i = 0; i < numPoints; ++i) {
+			auto frequency = minFrequency * std::exp (ratio * float (i) / float (numPoints - 1));
+			if (frequency >= 0.5f * sampleRate)
+				break;
+			auto w = MathConstants<float>::twoPi * frequency / sampleRate;
+			frequencies.push_back (frequency);
+			cosW.push_back (std::cos (w));
+			sinW.push_back (std::sin (w));
+		}
+	}
+
+	size_t size () const noexcept { return frequencies.size (); }
+};
+
+// Complex response on a ResponseGrid, held as separate real and imaginary arrays so that every
+// operation is a plain loop over floats the compiler can vectorise.
+struct ComplexResponse {
+	std::vector<float> re;
+	std::vector<float> im;
+
+	void setToConstant (const ResponseGrid& grid, float value) {
+		re.assign (grid.size (), value);
+		im.assign (grid.size (), 0.0f);
+	}
+
+	template <typename Coefficients>
+	void applyFilter (const ResponseGrid& grid, const Coefficients& coefficients) noexcept {
+		coefficients.applyToResponse (grid.cosW.data (), grid.sinW.data (), re.data (), im.data (), re.size ());
+	}
+
+	/** Delay by a whole or fractional number of samples; negative values advance. */
+	void applyDelay (const ResponseGrid& grid, float samples) noexcept {
+		for (size_t i = 0; i < re.size (); ++i) {
+			auto w = MathConstants<float>::twoPi * grid.frequencies[i] / grid.sampleRate * samples;
+			auto c = std::cos (w), s = -std::sin (w);
+			auto x = re[i];
+			re[i] = x * c - im[i] * s;
+			im[i] = x * s + im[i] * c;
+		}
+	}
+
+	void multiplyBy (float gain) noexcept {
+		FloatVectorOperations::multiply (re.data (), gain, int (re.size ()));
+		FloatVectorOperations::multiply (im.data (), gain, int (im.size ()));
+	}
+
+	void multiplyBy (const ComplexResponse& other) noexcept {
+		jassert (other.re.size () == re.size ());
+		for (size_t i = 0; i < re.size (); ++i) {
+			auto x = re[i];
+			re[i] = x * other.re[i] - im[i] * other.im[i];
+			im[i] = x * other.im[i] + im[i] * other.re[i];
+		}
+	}
+
+	/** this += gain * other */
+	void addWithMultiply (const ComplexResponse& other, float gain) noexcept {
+		jassert (other.re.size () == re.size ());
+		FloatVectorOperations::addWithMultiply (re.data (), other.re.data (), gain, int (re.size ()));
+		FloatVectorOperations::addWithMultiply (im.data (), other.im.data (), gain, int (im.size ()));
+	}
+
+	void addConstant (float value) noexcept {
+		FloatVectorOperations::add (re.data (), value, int (re.size ()));
+	}
+
+	float getMagnitudedB (size_t i, float floordB = -100.0f) const noexcept {
+		return Decibels::gainToDecibels (std::sqrt (re[i] * re[i] + im[i] * im[i]), floordB);
+	}
+
+	/** Phase in radians, in (-pi, pi]. */
+	float getPhase (size_t i) const noexcept {
+		return std::atan2 (im[i], re[i]);
+	}
+};
+
+// Responses of the chain at the left ear, which the right mirrors while the head faces forwards.
+struct ResponseCurves {
+	// to the left input alone, direct path and shelves
+	ComplexResponse direct;
+	// to the right input alone, through the crossfeed path
+	ComplexResponse crossfeed;
+	// to a centred source, the same signal on both inputs
+	ComplexResponse centre;
+};
@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+	ResponseDisplay.cpp
+	Created: 19 Oct 2026 8:41:03pm
+	Author:  Abhinav Natarajan
+
+  ==============================================================================
+*/
+
+#include "ResponseDisplay.h"
+
+//==============================================================================
+ResponseDisplay::ResponseDisplay (CrossFeedAudioProcessor& p)
+    : processor (p)
+{
+    setOpaque (true);
+    lastKey.fill (std::numeric_limits<float>::quiet_NaN());
+    timerCallback();
+    startTimerHz (pollRate);
+}
+
+ResponseDisplay::~ResponseDisplay()
+{
+    stopTimer();
+}
+
+void ResponseDisplay::timerCallback()
+{
+    auto sampleRate = float (processor.getSampleRate());
+    if (sampleRate <= 0.0f)
+        return;
+
+    std::array<float, 9> key { *processor.gaindB, *processor.xGaindB, *processor.angle,
+                               *processor.headYaw, *processor.headWidth, *processor.shadowCutoff,
+                               float (processor.shadowOrder->getIndex()), *processor.headTracking ? 1.0f : 0.0f,
+                               sampleRate };
+    if (key == lastKey)
+        return;
+
+    if (sampleRate != grid.sampleRate)
+        grid.setUp (numPoints, minFrequency, maxFrequency, sampleRate);
+    processor.computeResponse (grid, curves);
+    lastKey = key;
+    repaint();
+}
+
+//==============================================================================
+void ResponseDisplay::paint (Graphics& g)
+{
+    g.fillAll (Colours::black);
+    auto area = getLocalBounds().toFloat().reduced (4.0f);
+
+    // decade lines, and a line every 6 dB with 0 dB picked out
+    g.setFont (11.0f);
+    for (auto frequency : { 100.0f, 1000.0f, 10000.0f })
+    {
+        auto x = frequencyToX (frequency, area);
+        g.setColour (Colours::darkgrey);
+        g.drawVerticalLine (int (x), area.getY(), area.getBottom());
+        g.drawText (frequency < 1000.0f ? String (int (frequency)) : String (int (frequency / 1000.0f)) + "k",
+                    Rectangle<float> (x + 2.0f, area.getBottom() - 12.0f, 30.0f, 12.0f), Justification::left);
+    }
+    for (auto dB = mindB + 6.0f; dB < maxdB; dB += 6.0f)
+    {
+        auto y = jmap (dB, mindB, maxdB, area.getBottom(), area.getY());
+        g.setColour (dB == 0.0f ? Colours::grey : Colours::darkgrey);
+        g.drawHorizontalLine (int (y), area.getX(), area.getRight());
+        g.drawText (String (int (dB)) + " dB", Rectangle<float> (area.getX() + 2.0f, y - 12.0f, 50.0f, 12.0f), Justification::left);
+    }
+    g.setColour (Colours::darkgrey);
+    g.drawRect (area);
+
+    if (grid.size() == 0 || curves.centre.re.size() != grid.size())
+        return;
+
+    // phase of the centre response behind the magnitudes, on a scale of +-180 degrees
+    g.setColour (Colours::grey);
+    g.strokePath (makePhasePath (curves.centre, area), PathStrokeType (1.0f));
+
+    g.setColour (Colours::lightblue);
+    g.strokePath (makeMagnitudePath (curves.direct, area), PathStrokeType (1.5f));
+    g.setColour (Colours::orange);
+    g.strokePath (makeMagnitudePath (curves.crossfeed, area), PathStrokeType (1.5f));
+    g.setColour (Colours::white);
+    g.strokePath (makeMagnitudePath (curves.centre, area), PathStrokeType (1.5f));
+
+    auto legend = area.removeFromRight (110.0f).removeFromTop (56.0f);
+    g.setColour (Colours::lightblue);
+    g.drawText ("Direct", legend.removeFromTop (14.0f), Justification::left);
+    g.setColour (Colours::orange);
+    g.drawText ("Crossfeed", legend.removeFromTop (14.0f), Justification::left);
+    g.setColour (Colours::white);
+    g.drawText ("Centre", legend.removeFromTop (14.0f), Justification::left);
+    g.setColour (Colours::grey);
+    g.drawText ("Centre phase", legend.removeFromTop (14.0f), Justification::left);
+}
+
+float ResponseDisplay::frequencyToX (float frequency, Rectangle<float> area) const
+{
+    return area.getX() + area.getWidth() * std::log (frequency / minFrequency) / std::log (maxFrequency / minFrequency);
+}
+
+Path ResponseDisplay::makeMagnitudePath (const ComplexResponse& response, Rectangle<float> area) const
+{
+    Path path;
+    for (size_t i = 0; i < grid.size(); ++i)
+    {
+        auto dB = jlimit (mindB, maxdB, response.getMagnitudedB (i, mindB));
+        auto x = frequencyToX (grid.frequencies[i], area);
+        auto y = jmap (dB, mindB, maxdB, area.getBottom(), area.getY());
+        if (i == 0)
+            path.startNewSubPath (x, y);
+        else
+            path.lineTo (x, y);
+    }
+    return path;
+}
+
+Path ResponseDisplay::makePhasePath (const ComplexResponse& response, Rectangle<float> area) const
+{
+    // a new subpath wherever the phase wraps, rather than a line across the display
+    Path path;
+    auto pi = MathConstants<float>::pi;
+    auto lastPhase = 0.0f;
+    for (size_t i = 0; i < grid.size(); ++i)
+    {
+        auto phase = response.getPhase (i);
+        auto x = frequencyToX (grid.frequencies[i], area);
+        auto y = jmap (phase, -pi, pi, area.getBottom(), area.getY());
+        if (i == 0 || std::abs (phase - lastPhase) > pi)
+            path.startNewSubPath (x, y);
+        else
+            path.lineTo (x, y);
+        lastPhase = phase;
+    }
+    return path;
+}
@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+	ResponseDisplay.h
+	Created: 19 Oct 2026 8:41:03pm
+	Author:  Abhinav Natarajan
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+//==============================================================================
+/** Magnitude and phase response of the chain at the left ear, evaluated analytically by the
+	processor from the parameter values. The curves are cached, and recomputed only when a timer
+	finds that a parameter or the sample rate has changed; no audio is ever measured.
+*/
+class ResponseDisplay : public Component, private Timer
+{
+public:
+	ResponseDisplay(CrossFeedAudioProcessor&);
+	~ResponseDisplay();
+
+	void paint(Graphics&) override;
+
+private:
+	static constexpr int pollRate { 15 };
+	static constexpr size_t numPoints { 256 };
+	static constexpr float minFrequency { 20.0f };
+	static constexpr float maxFrequency { 20000.0f };
+	static constexpr float mindB { -30.0f };
+	static constexpr float maxdB { 6.0f };
+
+	void timerCallback() override;
+
+	float frequencyToX(float frequency, Rectangle<float> area) const;
+	Path makeMagnitudePath(const ComplexResponse&, Rectangle<float> area) const;
+	Path makePhasePath(const ComplexResponse&, Rectangle<float> area) const;
+
+	CrossFeedAudioProcessor& processor;
+
+	// everything the curves depend on, as last computed
+	std::array<float, 9> lastKey {};
+	ResponseGrid grid;
+	ResponseCurves curves;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ResponseDisplay)
+};
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+	StateArena.h
+	Created: 19 Oct 2026 10:41:12am
+	Author:  Abhinav Natarajan
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// helper class that hands out the DSP state of a processor from a single contiguous allocation
+class StateArena {
+public:
+	StateArena () = default;
+	~StateArena () = default;
+
+	static constexpr size_t cacheLineSize { 64 };
+
+	/** Starts handing out memory from the beginning of the arena again. */
+	void beginLayout () noexcept {
+		used = 0;
+	}
+
+	/** Returns space for count objects of type T. An arena without storage returns nullptr and only
+		measures, so a layout can be run once to size the arena and again to place the state. */
+	template <typename T>
+	T* allocate (size_t count, size_t alignment = alignof (T)) noexcept {
+		jassert (alignment > 0 && (alignment & (alignment - 1)) == 0);
+		used = (used + alignment - 1) & ~(alignment - 1);
+		auto ptr = storage == nullptr ? nullptr : reinterpret_cast<T*> (storage + used);
+		used += count * sizeof (T);
+		jassert (storage == nullptr || used <= capacity);
+		return ptr;
+	}
+
+	/** Makes room for at least numBytes, starting on a cache line. Only reallocates when growing. */
+	void allocateStorage (size_t numBytes) {
+		if (numBytes > capacity) {
+			block.calloc (numBytes + cacheLineSize);
+			auto address = reinterpret_cast<uintptr_t> (block.get ());
+			storage = block.get () + ((cacheLineSize - (address & (cacheLineSize - 1))) & (cacheLineSize - 1));
+			capacity = numBytes;
+		}
+		beginLayout ();
+	}
+
+	size_t getBytesUsed () const noexcept {
+		return used;
+	}
+
+	size_t getCapacity () const noexcept {
+		return capacity;
+	}
+
+private:
+	HeapBlock<char> block;
+	char* storage { nullptr };
+	size_t capacity { 0 };
+	size_t used { 0 };
+
+	JUCE_DECLARE_NON_COPYABLE (StateArena)
+};